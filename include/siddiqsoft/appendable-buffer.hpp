@@ -0,0 +1,58 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#ifndef APPENDABLE_BUFFER_HPP
+#define APPENDABLE_BUFFER_HPP
+
+#include <concepts>
+#include <cstddef>
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief A growable contiguous buffer of bytes or characters such as std::string or std::vector<std::byte>
+    template <typename B>
+    concept AppendableBuffer = (sizeof(typename B::value_type) == 1) && requires(B& buffer, std::size_t n) {
+        { buffer.size() } -> std::convertible_to<std::size_t>;
+        { buffer.data() } -> std::convertible_to<typename B::value_type*>;
+        buffer.resize(n);
+    };
+} // namespace siddiqsoft
+
+#endif // !APPENDABLE_BUFFER_HPP
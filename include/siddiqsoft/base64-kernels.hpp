@@ -0,0 +1,772 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#ifndef BASE64_KERNELS_HPP
+#define BASE64_KERNELS_HPP
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "appendable-buffer.hpp"
+#include "cpu-features.hpp"
+#include "utf8-utils.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief The base64 alphabets defined by RFC 4648
+    enum class Base64Alphabet
+    {
+        /// @brief RFC 4648 §4 using `+` and `/`; padding is required when decoding
+        Standard,
+        /// @brief RFC 4648 §5 "base64url" using `-` and `_`; padding is optional when decoding
+        UrlSafe
+    };
+
+
+    /// @brief Platform neutral base64 codec kernels.
+    ///        The scalar kernel is always available; the SSE4.1, AVX2 and AVX-512 VBMI kernels are compiled on x86-64
+    ///        and selected at runtime based on `CpuFeatures`. Every kernel produces output identical to the scalar kernel.
+    /// @remarks These are the building blocks for `Base64Utils`; you should not need to call them directly.
+    struct Base64Kernels
+    {
+        /// @brief The available kernel implementations
+        enum class Kernel
+        {
+            Scalar,
+            SSE41,
+            AVX2,
+            AVX512VBMI
+        };
+
+
+        /// @brief Lookup tables for one alphabet; shared by the scalar and vector kernels
+        struct Alphabet
+        {
+            /// @brief The 64 characters in index order
+            alignas(64) std::array<char, 64> encode;
+            /// @brief Reverse of `encode`; 0xff marks characters outside of the alphabet (including `=`)
+            alignas(64) std::array<uint8_t, 256> decode;
+            /// @brief Offsets added to the 6-bit value to reach the alphabet character; indexed by the reduced value in
+            ///        the vector encoders: 0 = a-z, 1..10 = 0-9, 11 = index 62, 12 = index 63, 13 = A-Z
+            alignas(16) std::array<int8_t, 16> offsets;
+        };
+
+
+        static constexpr auto makeAlphabet = [](const char (&chars)[65]) {
+            Alphabet alphabet {};
+
+            alphabet.decode.fill(0xff);
+            for (uint8_t i = 0; i < 64; i++) {
+                alphabet.encode[i]                                     = chars[i];
+                alphabet.decode[static_cast<unsigned char>(chars[i])] = i;
+            }
+
+            alphabet.offsets[0] = 'a' - 26;
+            for (int i = 1; i <= 10; i++) alphabet.offsets[i] = '0' - 52;
+            alphabet.offsets[11] = static_cast<int8_t>(chars[62] - 62);
+            alphabet.offsets[12] = static_cast<int8_t>(chars[63] - 63);
+            alphabet.offsets[13] = 'A';
+            return alphabet;
+        };
+
+
+        /// @brief RFC 4648 §4 alphabet
+        static constexpr Alphabet StandardAlphabet =
+                makeAlphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+
+        /// @brief RFC 4648 §5 alphabet
+        static constexpr Alphabet UrlSafeAlphabet =
+                makeAlphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
+
+
+        /// @brief The lookup tables for the given alphabet
+        static constexpr const Alphabet& tables(Base64Alphabet alphabet) noexcept
+        {
+            return (alphabet == Base64Alphabet::UrlSafe) ? UrlSafeAlphabet : StandardAlphabet;
+        }
+
+
+        /// @brief Byte permutation taking the 24-bit groups (little-endian in 32-bit lanes) to a contiguous big-endian stream
+        alignas(64) static constexpr std::array<uint8_t, 64> DecodePack = [] {
+            std::array<uint8_t, 64> pack {};
+
+            for (uint8_t i = 0; i < 48; i++) pack[i] = static_cast<uint8_t>(((i / 3) * 4) + (2 - (i % 3)));
+            return pack;
+        }();
+
+
+        /// @brief Marker for "no error" in `DecodeResult::errorOffset`
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+
+        /// @brief Outcome of a decode operation
+        struct DecodeResult
+        {
+            /// @brief Number of bytes written to the destination
+            std::size_t written {0};
+            /// @brief Offset of the first character in the source that could not be decoded; `npos` on success
+            std::size_t errorOffset {npos};
+
+            constexpr explicit operator bool() const noexcept { return errorOffset == npos; }
+        };
+
+
+        /// @brief Number of characters required to encode `n` bytes
+        /// @param padding When false the trailing `=` are omitted (base64url as used by JWT)
+        static constexpr std::size_t encodedSize(std::size_t n, bool padding = true) noexcept
+        {
+            return padding ? (((n + 2) / 3) * 4) : (((n / 3) * 4) + (((n % 3) != 0) ? ((n % 3) + 1) : 0));
+        }
+
+
+        /// @brief Exact number of bytes produced by decoding the `n` characters in `src`; computed from the `=` padding
+        ///        or, for unpadded input, from the length of the final group.
+        ///        For malformed input this is an upper bound of what the decoder writes before it reports the error.
+        template <typename C = char>
+            requires std::same_as<C, char> || std::same_as<C, wchar_t>
+        static constexpr std::size_t decodedSize(const C* src, std::size_t n) noexcept
+        {
+            std::size_t padding = 0;
+
+            switch (n % 4) {
+                case 0:
+                    if ((n > 0) && (src[n - 1] == '=')) padding++;
+                    if ((n > 0) && (src[n - 2] == '=')) padding++;
+                    return ((n / 4) * 3) - padding;
+                case 1: return (n / 4) * 3;
+                default: return ((n / 4) * 3) + ((n % 4) - 1);
+            }
+        }
+
+
+        /// @brief Check if the given kernel may be used on this CPU
+        static bool isSupported(Kernel kernel) noexcept
+        {
+            const auto& cpu = CpuFeatures::current();
+
+            switch (kernel) {
+                case Kernel::Scalar: return true;
+#if defined(SIDDIQSOFT_X86_64)
+                case Kernel::SSE41: return cpu.sse41;
+                case Kernel::AVX2: return cpu.avx2;
+                case Kernel::AVX512VBMI: return cpu.avx512vbmi;
+#endif
+                default: return false;
+            }
+        }
+
+
+        /// @brief The fastest kernel supported by this CPU; determined once per process
+        static Kernel bestKernel() noexcept
+        {
+            static const Kernel kernel = [] {
+                if (isSupported(Kernel::AVX512VBMI)) return Kernel::AVX512VBMI;
+                if (isSupported(Kernel::AVX2)) return Kernel::AVX2;
+                if (isSupported(Kernel::SSE41)) return Kernel::SSE41;
+                return Kernel::Scalar;
+            }();
+
+            return kernel;
+        }
+
+
+        /// @brief Encode `n` bytes from `src` into `dst` using the best kernel for this CPU
+        /// @param dst Must have room for at least `encodedSize(n, padding)` characters
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return Number of characters written
+        static std::size_t encode(const unsigned char* src,
+                                  std::size_t          n,
+                                  char*                dst,
+                                  Base64Alphabet       alphabet = Base64Alphabet::Standard,
+                                  bool                 padding  = true) noexcept
+        {
+            return encode(src, n, dst, alphabet, padding, bestKernel());
+        }
+
+
+        /// @brief Encode `n` bytes from `src` into `dst` using the specified kernel
+        /// @param dst Must have room for at least `encodedSize(n, padding)` characters
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @param kernel The kernel must be supported by this CPU (see `isSupported`)
+        /// @return Number of characters written
+        static std::size_t
+        encode(const unsigned char* src, std::size_t n, char* dst, Base64Alphabet alphabet, bool padding, Kernel kernel) noexcept
+        {
+            const auto& table    = tables(alphabet);
+            std::size_t consumed = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            switch (kernel) {
+                case Kernel::AVX512VBMI: consumed = encodeBlocksAVX512VBMI(src, n, dst, table); break;
+                case Kernel::AVX2: consumed = encodeBlocksAVX2(src, n, dst, table); break;
+                case Kernel::SSE41: consumed = encodeBlocksSSE41(src, n, dst, table); break;
+                default: break;
+            }
+#endif
+
+            // The vector kernels consume whole 3-byte groups and leave the tail (and padding) to the scalar kernel
+            return ((consumed / 3) * 4) + encodeScalar(src + consumed, n - consumed, dst + ((consumed / 3) * 4), table, padding);
+        }
+
+
+        /// @brief Decode `n` characters from `src` into `dst` using the best kernel for this CPU
+        /// @param dst Must have room for at least `decodedSize(src, n)` bytes
+        /// @param alphabet The alphabet of the source
+        /// @return The number of bytes written and, on failure, the offset of the offending character
+        static DecodeResult
+        decode(const char* src, std::size_t n, unsigned char* dst, Base64Alphabet alphabet = Base64Alphabet::Standard) noexcept
+        {
+            return decode(src, n, dst, alphabet, bestKernel());
+        }
+
+
+        /// @brief Decode `n` characters from `src` into `dst` using the specified kernel.
+        ///        The standard alphabet must be padded to a multiple of four characters; base64url may omit the padding.
+        ///        Whitespace is not permitted; any character outside the alphabet is reported in the same pass that decodes.
+        ///        During constant evaluation the scalar kernel is used regardless of `kernel`.
+        /// @param dst Must have room for at least `decodedSize(src, n)` bytes
+        /// @param alphabet The alphabet of the source
+        /// @param kernel The kernel must be supported by this CPU (see `isSupported`)
+        /// @return The number of bytes written and, on failure, the offset of the offending character
+        template <typename B = unsigned char>
+            requires(sizeof(B) == 1)
+        static constexpr DecodeResult
+        decode(const char* src, std::size_t n, B* dst, Base64Alphabet alphabet, Kernel kernel) noexcept
+        {
+            const auto&       table     = tables(alphabet);
+            const std::size_t remainder = n % 4;
+            // Everything but the last group is free of padding and goes through the vector kernels in bulk.
+            const std::size_t body = (remainder == 0) ? ((n > 0) ? (n - 4) : 0) : (n - remainder);
+
+            auto result = decodeGroups(src, body, dst, alphabet, kernel);
+            if (!result) return result;
+
+            // A partial trailing group is only valid for unpadded base64url and never a lone character
+            if ((remainder == 1) || ((remainder > 1) && (alphabet != Base64Alphabet::UrlSafe))) return {result.written, body};
+
+            if (n > 0) {
+                auto last = decodeFinal(src + body, (remainder == 0) ? 4 : remainder, dst + result.written, table);
+                result.written += last.written;
+                if (!last) result.errorOffset = body + last.errorOffset;
+            }
+
+            return result;
+        }
+
+
+        /// @brief Decode whole 4-character groups without padding using the specified kernel; the building block for
+        ///        `decode` and the streaming decoder.
+        /// @param n Must be a multiple of four
+        /// @param dst Must have room for at least `(n / 4) * 3` bytes
+        /// @return The number of bytes written and, on failure, the offset of the offending character (`=` included)
+        template <typename B = unsigned char>
+            requires(sizeof(B) == 1)
+        static constexpr DecodeResult
+        decodeGroups(const char* src, std::size_t n, B* dst, Base64Alphabet alphabet, Kernel kernel) noexcept
+        {
+            const auto& table    = tables(alphabet);
+            std::size_t consumed = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            if (!std::is_constant_evaluated()) {
+                auto out = reinterpret_cast<unsigned char*>(dst);
+
+                switch (kernel) {
+                    case Kernel::AVX512VBMI: consumed = decodeBlocksAVX512VBMI(src, n, out, table); break;
+                    case Kernel::AVX2: consumed = decodeBlocksAVX2(src, n, out, table); break;
+                    case Kernel::SSE41: consumed = decodeBlocksSSE41(src, n, out, table); break;
+                    default: break;
+                }
+            }
+#endif
+
+            // The vector kernels stop short of a block containing an invalid character; the scalar kernel pinpoints it
+            auto result = decodeScalar(src + consumed, n - consumed, dst + ((consumed / 4) * 3), table);
+            result.written += (consumed / 4) * 3;
+            if (!result) result.errorOffset += consumed;
+            return result;
+        }
+
+
+        /// @brief Portable decoder for whole 4-character groups without padding
+        /// @return The number of bytes written and, on failure, the offset of the offending character
+        template <typename B = unsigned char>
+            requires(sizeof(B) == 1)
+        static constexpr DecodeResult decodeScalar(const char* src, std::size_t n, B* dst, const Alphabet& table) noexcept
+        {
+            DecodeResult result {};
+
+            for (std::size_t i = 0; (i + 4) <= n; i += 4) {
+                const uint8_t a = table.decode[static_cast<unsigned char>(src[i])];
+                const uint8_t b = table.decode[static_cast<unsigned char>(src[i + 1])];
+                const uint8_t c = table.decode[static_cast<unsigned char>(src[i + 2])];
+                const uint8_t d = table.decode[static_cast<unsigned char>(src[i + 3])];
+
+                if ((a | b | c | d) & 0x80) {
+                    result.errorOffset = i + ((a & 0x80) ? 0 : (b & 0x80) ? 1 : (c & 0x80) ? 2 : 3);
+                    return result;
+                }
+
+                const uint32_t group = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+
+                dst[result.written++] = static_cast<B>(static_cast<unsigned char>(group >> 16));
+                dst[result.written++] = static_cast<B>(static_cast<unsigned char>(group >> 8));
+                dst[result.written++] = static_cast<B>(static_cast<unsigned char>(group));
+            }
+
+            return result;
+        }
+
+
+        /// @brief Decode the final group: four characters which may end with one or two `=` or, when unpadded, two or three
+        template <typename B = unsigned char>
+            requires(sizeof(B) == 1)
+        static constexpr DecodeResult decodeFinal(const char* src, std::size_t length, B* dst, const Alphabet& table) noexcept
+        {
+            const uint8_t a = table.decode[static_cast<unsigned char>(src[0])];
+            const uint8_t b = table.decode[static_cast<unsigned char>(src[1])];
+            const uint8_t c = (length > 2) ? table.decode[static_cast<unsigned char>(src[2])] : 0xff;
+            const uint8_t d = (length > 3) ? table.decode[static_cast<unsigned char>(src[3])] : 0xff;
+
+            if (a & 0x80) return {0, 0};
+            if (b & 0x80) return {0, 1};
+            // Padding is only valid as "xx==" or "xxx="
+            if ((length > 2) && (c & 0x80) && ((length < 4) || (src[2] != '=') || (src[3] != '='))) return {0, 2};
+            if ((length > 3) && (d & 0x80) && (src[3] != '=')) return {0, 3};
+
+            const uint32_t group = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c & 0x3f) << 6) | uint32_t(d & 0x3f);
+
+            dst[0] = static_cast<B>(static_cast<unsigned char>(group >> 16));
+            if (c & 0x80) return {1, npos};
+            dst[1] = static_cast<B>(static_cast<unsigned char>(group >> 8));
+            if (d & 0x80) return {2, npos};
+            dst[2] = static_cast<B>(static_cast<unsigned char>(group));
+            return {3, npos};
+        }
+
+
+        /// @brief Encode the UTF-8 form of the wide source straight into wchar_t output.
+        ///        The source is transcoded into a small stack buffer which is encoded by the vector kernels and widened into
+        ///        `dst`; no intermediate strings.
+        /// @param dst Must have room for at least `encodedSize(Utf8Utils::encodedLength(src), padding)` characters
+        /// @return Number of characters written
+        static std::size_t
+        encodeWide(const wchar_t* src, std::size_t n, wchar_t* dst, Base64Alphabet alphabet, bool padding) noexcept
+        {
+            // A multiple of three so every chunk but the last encodes without a partial group; the slack holds the code
+            // point which crosses the chunk boundary.
+            constexpr std::size_t ChunkBytes = 3 * 256;
+
+            unsigned char  bytes[ChunkBytes + 4];
+            char           encoded[encodedSize(ChunkBytes + 4)];
+            std::size_t    length = 0;
+            wchar_t*       out    = dst;
+            const wchar_t* end    = src + n;
+
+            for (;;) {
+                while ((src < end) && (length < ChunkBytes)) {
+                    if (static_cast<std::make_unsigned_t<wchar_t>>(*src) < 0x80)
+                        bytes[length++] = static_cast<unsigned char>(*src++);
+                    else
+                        length += Utf8Utils::encodeCodePoint(Utf8Utils::nextCodePoint(src, end), bytes + length);
+                }
+
+                // The last chunk takes the tail and padding
+                const auto whole   = (src < end) ? ((length / 3) * 3) : length;
+                const auto written = encode(bytes, whole, encoded, alphabet, padding);
+
+                for (std::size_t i = 0; i < written; i++) out[i] = static_cast<wchar_t>(encoded[i]);
+                out += written;
+
+                if (src >= end) break;
+                std::memmove(bytes, bytes + whole, length - whole);
+                length -= whole;
+            }
+
+            return static_cast<std::size_t>(out - dst);
+        }
+
+
+        /// @brief Decode the wide source and transcode the decoded UTF-8 straight into wchar_t output.
+        ///        The source is narrowed into a small stack buffer (anything outside of ASCII is invalid), decoded by the vector
+        ///        kernels and transcoded into `dst`; no intermediate strings. Validation is the same as `decode`.
+        /// @param dst Must have room for at least `decodedSize` of the source; never more than one wchar_t per decoded byte
+        /// @return The number of wchar_t written and, on failure, the offset of the offending character
+        static DecodeResult decodeWide(const wchar_t* src, std::size_t n, wchar_t* dst, Base64Alphabet alphabet) noexcept
+        {
+            constexpr std::size_t ChunkChars = 4 * 256;
+
+            char           narrow[ChunkChars];
+            unsigned char  bytes[((ChunkChars / 4) * 3) + 4];
+            std::size_t    carry     = 0;
+            wchar_t*       out       = dst;
+            const auto     remainder = n % 4;
+            // The last group (which may be padded) is decoded separately as in `decode`
+            const auto body = (remainder == 0) ? ((n > 0) ? (n - 4) : 0) : (n - remainder);
+
+            auto narrowChunk = [&](std::size_t start, std::size_t length) {
+                for (std::size_t i = 0; i < length; i++) {
+                    const auto ch = static_cast<std::make_unsigned_t<wchar_t>>(src[start + i]);
+                    narrow[i]     = (ch < 0x80) ? static_cast<char>(ch) : '\x80';
+                }
+            };
+
+            // Transcode the decoded bytes; an incomplete UTF-8 sequence is carried into the next chunk
+            auto widen = [&](std::size_t length, bool final) {
+                std::size_t consumed = 0;
+
+                out += Utf8Utils::toWide(bytes, length, out, final, consumed);
+                std::memmove(bytes, bytes + consumed, length - consumed);
+                carry = length - consumed;
+            };
+
+            for (std::size_t start = 0; start < body; start += ChunkChars) {
+                const auto length = std::min(ChunkChars, body - start);
+
+                narrowChunk(start, length);
+                auto result = decodeGroups(narrow, length, bytes + carry, alphabet, bestKernel());
+                if (!result) return {static_cast<std::size_t>(out - dst), start + result.errorOffset};
+                widen(carry + result.written, false);
+            }
+
+            narrowChunk(body, n - body);
+            auto last = decode(narrow, n - body, bytes + carry, alphabet, Kernel::Scalar);
+            if (!last) return {static_cast<std::size_t>(out - dst), body + last.errorOffset};
+            widen(carry + last.written, true);
+
+            return {static_cast<std::size_t>(out - dst), npos};
+        }
+
+
+        /// @brief Portable encoder; also handles the final partial group and the `=` padding.
+        ///        Usable during constant evaluation with any byte-sized source (char, unsigned char or std::byte).
+        /// @return Number of characters written
+        template <typename B = unsigned char>
+            requires(sizeof(B) == 1)
+        static constexpr std::size_t
+        encodeScalar(const B* src, std::size_t n, char* dst, const Alphabet& table, bool padding = true) noexcept
+        {
+            char*       out  = dst;
+            std::size_t i    = 0;
+            auto        byte = [src](std::size_t at) { return uint32_t(static_cast<unsigned char>(src[at])); };
+
+            for (; (i + 3) <= n; i += 3) {
+                const uint32_t group = (byte(i) << 16) | (byte(i + 1) << 8) | byte(i + 2);
+
+                *out++ = table.encode[(group >> 18) & 0x3f];
+                *out++ = table.encode[(group >> 12) & 0x3f];
+                *out++ = table.encode[(group >> 6) & 0x3f];
+                *out++ = table.encode[group & 0x3f];
+            }
+
+            if (const auto remaining = n - i; remaining > 0) {
+                const uint32_t group = (byte(i) << 16) | ((remaining == 2) ? (byte(i + 1) << 8) : 0);
+
+                *out++ = table.encode[(group >> 18) & 0x3f];
+                *out++ = table.encode[(group >> 12) & 0x3f];
+                if (remaining == 2) *out++ = table.encode[(group >> 6) & 0x3f];
+                if (padding) {
+                    if (remaining == 1) *out++ = '=';
+                    *out++ = '=';
+                }
+            }
+
+            return static_cast<std::size_t>(out - dst);
+        }
+
+#if defined(SIDDIQSOFT_X86_64)
+        // The vector kernels follow the approach described by Wojciech Muła and Daniel Lemire in
+        // "Faster Base64 Encoding and Decoding Using AVX2 Instructions" (ACM TOW 2018) and
+        // "Base64 encoding and decoding at almost the speed of a memory copy" (SPE 2019).
+        // Each returns the number of input bytes consumed which is always a multiple of three.
+
+        /// @brief Split 12 bytes (in the lower 12 lanes) into sixteen 6-bit indices and map them onto the alphabet
+        SIDDIQSOFT_TARGET("sse4.1")
+        static __m128i encodeLanesSSE41(__m128i in, __m128i offsets) noexcept
+        {
+            in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+            const __m128i t0      = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+            const __m128i t1      = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+            const __m128i t2      = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+            const __m128i t3      = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+            const __m128i indices = _mm_or_si128(t1, t3);
+
+            // Reduce the index into one of the alphabet ranges and add the range offset
+            __m128i       reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+            const __m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+            reduced               = _mm_or_si128(reduced, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+
+            return _mm_add_epi8(_mm_shuffle_epi8(offsets, reduced), indices);
+        }
+
+
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t encodeBlocksSSE41(const unsigned char* src, std::size_t n, char* dst, const Alphabet& table) noexcept
+        {
+            const __m128i offsets  = _mm_load_si128(reinterpret_cast<const __m128i*>(table.offsets.data()));
+            std::size_t   consumed = 0;
+
+            // Each round loads 16 bytes but consumes only 12 so we stop while the load is still in bounds
+            for (; (n - consumed) >= 16; consumed += 12, dst += 16) {
+                const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), encodeLanesSSE41(in, offsets));
+            }
+
+            return consumed;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t encodeBlocksAVX2(const unsigned char* src, std::size_t n, char* dst, const Alphabet& table) noexcept
+        {
+            const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+            const __m256i offsets =
+                    _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table.offsets.data())));
+            std::size_t   consumed = 0;
+
+            // Two 12-byte groups per round; one per 128-bit lane. The upper load reads 16 bytes starting at +12.
+            for (; (n - consumed) >= 28; consumed += 24, dst += 32) {
+                const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+                const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed + 12));
+                __m256i       in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuffle);
+
+                const __m256i t0      = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+                const __m256i t1      = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+                const __m256i t2      = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+                const __m256i t3      = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+                const __m256i indices = _mm256_or_si256(t1, t3);
+
+                __m256i       reduced = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+                const __m256i isUpper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+                reduced               = _mm256_or_si256(reduced, _mm256_and_si256(isUpper, _mm256_set1_epi8(13)));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                                    _mm256_add_epi8(_mm256_shuffle_epi8(offsets, reduced), indices));
+            }
+
+            return consumed;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx512f,avx512bw,avx512vbmi")
+        static std::size_t
+        encodeBlocksAVX512VBMI(const unsigned char* src, std::size_t n, char* dst, const Alphabet& table) noexcept
+        {
+            // Gather the bytes of each 3-byte group into 32-bit lanes (b1 b0 b2 b1) and let the multishift extract
+            // the four 6-bit fields; the alphabet is a single 64-byte permute table.
+            const __m512i shuffle  = _mm512_setr_epi32(0x01020001,
+                                                      0x04050304,
+                                                      0x07080607,
+                                                      0x0a0b090a,
+                                                      0x0d0e0c0d,
+                                                      0x10110f10,
+                                                      0x13141213,
+                                                      0x16171516,
+                                                      0x191a1819,
+                                                      0x1c1d1b1c,
+                                                      0x1f201e1f,
+                                                      0x22232122,
+                                                      0x25262425,
+                                                      0x28292728,
+                                                      0x2b2c2a2b,
+                                                      0x2e2f2d2e);
+            const __m512i shifts   = _mm512_set1_epi64(0x3036242a1016040aLL);
+            const __m512i alphabet = _mm512_load_si512(table.encode.data());
+            std::size_t   consumed = 0;
+
+            // The masked load only touches the 48 bytes we consume
+            for (; (n - consumed) >= 48; consumed += 48, dst += 64) {
+                const __m512i in      = _mm512_maskz_loadu_epi8(0x0000ffffffffffffULL, src + consumed);
+                const __m512i indices = _mm512_multishift_epi64_epi8(shifts, _mm512_permutexvar_epi8(shuffle, in));
+
+                _mm512_storeu_si512(dst, _mm512_permutexvar_epi8(indices, alphabet));
+            }
+
+            return consumed;
+        }
+
+
+        // The vector decoders validate and translate every character by range; anything outside the alphabet stops the
+        // kernel before that block so the scalar decoder can report the exact offset. The 6-bit values are then
+        // packed with multiply-add (a * 64 + b, ab * 4096 + cd) and shuffled into big-endian byte order.
+        // Each returns the number of characters consumed which is always a multiple of four.
+
+        /// @brief Translate sixteen characters into their 6-bit values; `valid` receives the per-lane validity mask
+        SIDDIQSOFT_TARGET("sse4.1")
+        static __m128i decodeLanesSSE41(__m128i in, const Alphabet& table, int& valid) noexcept
+        {
+            const __m128i isUpper =
+                    _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('Z' + 1)));
+            const __m128i isLower =
+                    _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('z' + 1)));
+            const __m128i isDigit =
+                    _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+            const __m128i is62 = _mm_cmpeq_epi8(in, _mm_set1_epi8(table.encode[62]));
+            const __m128i is63 = _mm_cmpeq_epi8(in, _mm_set1_epi8(table.encode[63]));
+
+            valid = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(isUpper, isLower), _mm_or_si128(isDigit, is62)), is63));
+
+            __m128i roll = _mm_and_si128(isUpper, _mm_set1_epi8(-'A'));
+            roll         = _mm_or_si128(roll, _mm_and_si128(isLower, _mm_set1_epi8(26 - 'a')));
+            roll         = _mm_or_si128(roll, _mm_and_si128(isDigit, _mm_set1_epi8(52 - '0')));
+            roll         = _mm_or_si128(roll, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - table.encode[62]))));
+            roll         = _mm_or_si128(roll, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - table.encode[63]))));
+
+            const __m128i values = _mm_add_epi8(in, roll);
+            const __m128i merged =
+                    _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+
+            return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        }
+
+
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t decodeBlocksSSE41(const char* src, std::size_t n, unsigned char* dst, const Alphabet& table) noexcept
+        {
+            std::size_t consumed = 0;
+            int         valid    = 0;
+
+            for (; (n - consumed) >= 16; consumed += 16, dst += 12) {
+                const __m128i in  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+                const __m128i out = decodeLanesSSE41(in, table, valid);
+                if (valid != 0xffff) break;
+
+                // Store exactly 12 bytes near the end; the destination may be sized to the decoded length
+                if ((n - consumed) >= 24) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+                }
+                else {
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), out);
+                    const auto upper = static_cast<uint32_t>(_mm_extract_epi32(out, 2));
+                    std::memcpy(dst + 8, &upper, sizeof(upper));
+                }
+            }
+
+            return consumed;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t decodeBlocksAVX2(const char* src, std::size_t n, unsigned char* dst, const Alphabet& table) noexcept
+        {
+            const __m256i pack =
+                    _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 32; consumed += 32, dst += 24) {
+                const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + consumed));
+
+                const __m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)),
+                                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in));
+                const __m256i isLower = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)),
+                                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in));
+                const __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+                                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+                const __m256i is62    = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(table.encode[62]));
+                const __m256i is63    = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(table.encode[63]));
+
+                const __m256i valid =
+                        _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(isUpper, isLower), _mm256_or_si256(isDigit, is62)), is63);
+                if (static_cast<uint32_t>(_mm256_movemask_epi8(valid)) != 0xffffffffu) break;
+
+                __m256i roll = _mm256_and_si256(isUpper, _mm256_set1_epi8(-'A'));
+                roll = _mm256_or_si256(roll, _mm256_and_si256(isLower, _mm256_set1_epi8(26 - 'a')));
+                roll = _mm256_or_si256(roll, _mm256_and_si256(isDigit, _mm256_set1_epi8(52 - '0')));
+                roll = _mm256_or_si256(roll, _mm256_and_si256(is62, _mm256_set1_epi8(static_cast<char>(62 - table.encode[62]))));
+                roll = _mm256_or_si256(roll, _mm256_and_si256(is63, _mm256_set1_epi8(static_cast<char>(63 - table.encode[63]))));
+
+                const __m256i values = _mm256_add_epi8(in, roll);
+                const __m256i merged =
+                        _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+                // 12 bytes per lane; gather them into the lower 24 bytes and store exactly that much
+                const __m256i out =
+                        _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+                // Store exactly 24 bytes near the end; the destination may be sized to the decoded length
+                if ((n - consumed) >= 48) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+                }
+                else {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(out));
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), _mm256_extracti128_si256(out, 1));
+                }
+            }
+
+            return consumed;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx512f,avx512bw,avx512vbmi")
+        static std::size_t
+        decodeBlocksAVX512VBMI(const char* src, std::size_t n, unsigned char* dst, const Alphabet& table) noexcept
+        {
+            // The first half of the decode table covers ASCII; the two-source permute uses the low seven bits of each
+            // character so non-ASCII input is rejected separately by its own high bit.
+            const __m512i lookupLo = _mm512_load_si512(table.decode.data());
+            const __m512i lookupHi = _mm512_load_si512(table.decode.data() + 64);
+            const __m512i pack     = _mm512_loadu_si512(DecodePack.data());
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 64; consumed += 64, dst += 48) {
+                const __m512i in     = _mm512_loadu_si512(src + consumed);
+                const __m512i values = _mm512_permutex2var_epi8(lookupLo, in, lookupHi);
+
+                if (_mm512_movepi8_mask(_mm512_or_si512(values, in)) != 0) break;
+
+                const __m512i merged = _mm512_madd_epi16(_mm512_maddubs_epi16(values, _mm512_set1_epi32(0x01400140)),
+                                                         _mm512_set1_epi32(0x00011000));
+
+                _mm512_mask_storeu_epi8(dst, 0x0000ffffffffffffULL, _mm512_permutexvar_epi8(pack, merged));
+            }
+
+            return consumed;
+        }
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !BASE64_KERNELS_HPP
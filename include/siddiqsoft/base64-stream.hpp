@@ -0,0 +1,248 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#ifndef BASE64_STREAM_HPP
+#define BASE64_STREAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "base64-kernels.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Incremental base64 encoder for payloads that arrive (or are produced) in chunks.
+    ///        Up to two bytes are carried across `update` calls so each call only emits whole 4-character groups;
+    ///        memory use is bounded by the chunk size and not the payload size.
+    /// @remarks The output is identical to encoding the concatenated chunks with `Base64Utils::encode`.
+    class Base64Encoder
+    {
+    public:
+        /// @brief Create an encoder
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=` from `finish`
+        explicit Base64Encoder(Base64Alphabet outputAlphabet = Base64Alphabet::Standard, bool emitPadding = true) noexcept
+            : alphabet(outputAlphabet)
+            , padding(emitPadding)
+        {
+        }
+
+
+        /// @brief Encode the chunk (along with the bytes carried from the previous call) and append to the buffer
+        /// @param chunk The next bytes of the payload
+        /// @param dest Buffer to append; for example std::string or std::vector<char>
+        /// @return Number of characters appended
+        template <AppendableBuffer B>
+        std::size_t update(std::span<const std::byte> chunk, B& dest)
+        {
+            auto        src       = reinterpret_cast<const unsigned char*>(chunk.data());
+            std::size_t remaining = chunk.size();
+            const auto  start     = dest.size();
+
+            dest.resize(start + (((pendingLength + remaining) / 3) * 4));
+            auto out = reinterpret_cast<char*>(dest.data()) + start;
+
+            // Complete the group carried over from the previous call
+            if ((pendingLength > 0) && ((pendingLength + remaining) >= 3)) {
+                const auto fill = 3 - pendingLength;
+
+                std::memcpy(pending.data() + pendingLength, src, fill);
+                out += Base64Kernels::encode(pending.data(), 3, out, alphabet, padding);
+                src += fill;
+                remaining -= fill;
+                pendingLength = 0;
+            }
+
+            if (pendingLength == 0) {
+                const auto whole = (remaining / 3) * 3;
+
+                Base64Kernels::encode(src, whole, out, alphabet, padding);
+                src += whole;
+                remaining -= whole;
+            }
+
+            std::memcpy(pending.data() + pendingLength, src, remaining);
+            pendingLength += remaining;
+            return dest.size() - start;
+        }
+
+
+        /// @brief Encode the carried bytes (and padding) and append to the buffer. The encoder may be reused afterwards.
+        /// @param dest Buffer to append; for example std::string or std::vector<char>
+        /// @return Number of characters appended
+        template <AppendableBuffer B>
+        std::size_t finish(B& dest)
+        {
+            const auto start = dest.size();
+
+            dest.resize(start + Base64Kernels::encodedSize(pendingLength, padding));
+            Base64Kernels::encode(pending.data(), pendingLength, reinterpret_cast<char*>(dest.data()) + start, alphabet, padding);
+            pendingLength = 0;
+            return dest.size() - start;
+        }
+
+    private:
+        Base64Alphabet               alphabet {Base64Alphabet::Standard};
+        bool                         padding {true};
+        std::array<unsigned char, 3> pending {};
+        std::size_t                  pendingLength {0};
+    };
+
+
+    /// @brief Incremental base64 decoder for encoded payloads that arrive in arbitrary fragments (for example off a socket).
+    ///        Up to four characters are carried across `update` calls; the last group is held back until `finish` since
+    ///        only the final group may carry padding. Memory use is bounded by the chunk size and not the payload size.
+    /// @remarks Validation is as strict as `Base64Utils::decode`. Error offsets are relative to the start of the stream.
+    ///          Once an error is reported every further call reports the same error until `reset`.
+    class Base64Decoder
+    {
+    public:
+        /// @brief Create a decoder
+        /// @param alphabet The alphabet of the source; padding is optional for `Base64Alphabet::UrlSafe`
+        explicit Base64Decoder(Base64Alphabet sourceAlphabet = Base64Alphabet::Standard) noexcept
+            : alphabet(sourceAlphabet)
+        {
+        }
+
+
+        /// @brief Decode the chunk (along with the characters carried from the previous call) and append to the buffer.
+        ///        On failure nothing from this call is appended.
+        /// @param chunk The next characters of the encoded payload
+        /// @param dest Buffer to append; for example std::vector<std::byte> or std::string
+        /// @return The number of bytes appended and, on failure, the offset in the stream of the offending character
+        template <AppendableBuffer B>
+        Base64Kernels::DecodeResult update(std::string_view chunk, B& dest)
+        {
+            if (errorOffset != Base64Kernels::npos) return {0, errorOffset};
+
+            const auto total = pendingLength + chunk.size();
+            // Hold back the last group (complete or not) as it may be the final one and carry padding
+            const auto  holdBack = ((total % 4) == 0) ? std::min<std::size_t>(4, total) : (total % 4);
+            const auto  groups   = total - holdBack;
+            const auto  start    = dest.size();
+            std::size_t carried  = 0;
+
+            dest.resize(start + ((groups / 4) * 3));
+            auto out = reinterpret_cast<unsigned char*>(dest.data()) + start;
+
+            Base64Kernels::DecodeResult result {};
+
+            // Complete the group carried over from the previous call
+            if ((groups > 0) && (pendingLength > 0)) {
+                const auto fill = 4 - pendingLength;
+
+                chunk.copy(pending.data() + pendingLength, fill);
+                chunk.remove_prefix(fill);
+                result        = Base64Kernels::decodeGroups(pending.data(), 4, out, alphabet, Base64Kernels::bestKernel());
+                carried       = 4;
+                pendingLength = 0;
+            }
+
+            if (result && (groups > carried)) {
+                auto bulk = Base64Kernels::decodeGroups(
+                        chunk.data(), groups - carried, out + result.written, alphabet, Base64Kernels::bestKernel());
+                result.written += bulk.written;
+                if (!bulk) result.errorOffset = carried + bulk.errorOffset;
+                chunk.remove_prefix(groups - carried);
+            }
+
+            if (!result) {
+                dest.resize(start);
+                errorOffset = position + result.errorOffset;
+                return {0, errorOffset};
+            }
+
+            position += groups;
+            chunk.copy(pending.data() + pendingLength, chunk.size());
+            pendingLength += chunk.size();
+            return result;
+        }
+
+
+        /// @brief Decode the held back final group and append to the buffer. On success the decoder may be reused.
+        /// @param dest Buffer to append; for example std::vector<std::byte> or std::string
+        /// @return The number of bytes appended and, on failure, the offset in the stream of the offending character
+        template <AppendableBuffer B>
+        Base64Kernels::DecodeResult finish(B& dest)
+        {
+            if (errorOffset != Base64Kernels::npos) return {0, errorOffset};
+
+            const auto start = dest.size();
+
+            dest.resize(start + Base64Kernels::decodedSize(pending.data(), pendingLength));
+            auto result = Base64Kernels::decode(pending.data(),
+                                                pendingLength,
+                                                reinterpret_cast<unsigned char*>(dest.data()) + start,
+                                                alphabet,
+                                                Base64Kernels::Kernel::Scalar);
+            if (!result) {
+                dest.resize(start);
+                errorOffset = position + result.errorOffset;
+                return {0, errorOffset};
+            }
+
+            reset();
+            return result;
+        }
+
+
+        /// @brief Discard any carried characters and error so the decoder may start a new stream
+        void reset() noexcept
+        {
+            pendingLength = 0;
+            position      = 0;
+            errorOffset   = Base64Kernels::npos;
+        }
+
+    private:
+        Base64Alphabet      alphabet {Base64Alphabet::Standard};
+        std::array<char, 4> pending {};
+        std::size_t         pendingLength {0};
+        /// @brief Characters decoded so far; the base for error offsets
+        std::size_t         position {0};
+        std::size_t         errorOffset {Base64Kernels::npos};
+    };
+} // namespace siddiqsoft
+
+#endif // !BASE64_STREAM_HPP
@@ -48,11 +48,23 @@
 #include <format>
 #include <algorithm>
 #include <ranges>
+#include <span>
+#include <string_view>
+#include <cstddef>
+#include <stdexcept>
+#include <atomic>
+#include <functional>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <array>
 
 #include "openssl/ssl.h"
 #include "openssl/crypto.h"
 #include "openssl/evp.h"
 
+#include "base64-kernels.hpp"
+
 
 /// @brief SiddiqSoft
 namespace siddiqsoft
@@ -67,10 +79,10 @@ namespace siddiqsoft
         /// @return url encoded base64 source string
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> urlEscape(const std::basic_string<T>& src)
+        static std::basic_string<T> urlEscape(std::type_identity_t<std::basic_string_view<T>> src)
         {
             if (!src.empty()) {
-                auto encodeVal {src};
+                std::basic_string<T> encodeVal {src};
 
                 // Make the value url-safe per https://tools.ietf.org/html/rfc4648#section-5
                 if constexpr (std::is_same_v<T, char>) {
@@ -105,35 +117,44 @@ namespace siddiqsoft
         }
 
 
+        /// @brief URL escape the base64 encoded string; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> urlEscape(const std::basic_string<T, Traits, Alloc>& src)
+        {
+            return urlEscape<T>(std::basic_string_view<T>(src));
+        }
+
+
         /// @brief Base64 encode a given "binary" string and optionally url escape
         /// @param argBin The bytes to encode
+        /// @param alphabet Use `Base64Alphabet::UrlSafe` to emit base64url directly (same result as `urlEscape(encode(x))`
+        /// when `padding` is false but without the extra passes)
+        /// @param padding Emit the trailing `=`
         /// @return Base64 encoded string
         /// @remarks This is not a generic be-all implementation. For this, you should really call the underlying function directly
         /// with the necessary options. The implementation here is focussed on meeting the requirements for Azure services.
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> encode(const std::basic_string<T>& source)
+        static std::basic_string<T> encode(std::type_identity_t<std::basic_string_view<T>> source,
+                                           Base64Alphabet                                  alphabet = Base64Alphabet::Standard,
+                                           bool                                            padding  = true)
         {
             if constexpr (std::is_same_v<T, char>) {
-                // The OpenSSL interface only supports char/utf-8
-                uint32_t destSize = 0;
-                // Overallocate the destination buffer this is especially true for utf-8 contents
-                std::basic_string<T> dest(4 * source.length(), 0);
-
-                if (destSize = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(dest.data()),
-                                               reinterpret_cast<const unsigned char*>(source.data()),
-                                               source.length());
-                    destSize > 0)
-                {
-                    dest.resize(destSize);
-                    return dest;
-                }
+                // The kernels are byte-identical to EVP_EncodeBlock but pick the widest vector unit available at runtime.
+                // The destination is sized exactly so there is no shrink afterwards.
+                std::basic_string<T> dest(Base64Kernels::encodedSize(source.length(), padding), 0);
+
+                Base64Kernels::encode(
+                        reinterpret_cast<const unsigned char*>(source.data()), source.length(), dest.data(), alphabet, padding);
+                return dest;
             }
             else {
-                // Convert the source to char from wchar_t
-                // encode as char
-                // Then encode the result back to the wchar_t
-                return ConversionUtils::convert_to<char, wchar_t>(encode<char>(ConversionUtils::convert_to<wchar_t, char>(source)));
+                // The UTF-8 form of the source is encoded in one fused pass; the output is sized exactly up front
+                std::basic_string<T> dest(Base64Kernels::encodedSize(Utf8Utils::encodedLength(source), padding), 0);
+
+                Base64Kernels::encodeWide(source.data(), source.length(), dest.data(), alphabet, padding);
+                return dest;
             }
 
             // Fall-through is failure; return empty string
@@ -141,47 +162,514 @@ namespace siddiqsoft
         }
 
 
+        /// @brief Base64 encode a given "binary" string; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> encode(const std::basic_string<T, Traits, Alloc>& source,
+                                           Base64Alphabet                              alphabet = Base64Alphabet::Standard,
+                                           bool                                        padding  = true)
+        {
+            return encode<T>(std::basic_string_view<T>(source), alphabet, padding);
+        }
+
+
+        /// @brief Base64 encode the bytes
+        /// @param source The bytes to encode
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return Base64 encoded string
+        static std::string
+        encode(std::span<const std::byte> source, Base64Alphabet alphabet = Base64Alphabet::Standard, bool padding = true)
+        {
+            std::string dest(Base64Kernels::encodedSize(source.size(), padding), 0);
+
+            Base64Kernels::encode(
+                    reinterpret_cast<const unsigned char*>(source.data()), source.size(), dest.data(), alphabet, padding);
+            return dest;
+        }
+
+
         /// @brief Base64 decode the given encoded string back to the binary value
         /// @param textuallyEncoded Previously encoded value.
-        /// @return Base64 decoded string
+        /// @return Base64 decoded string; empty if the source is not valid base64
         /// @remarks This is not a generic be-all implementation. For this, you should really call the underlying function directly
         /// with the necessary options. The implementation here is focussed on meeting the requirements for Azure services.
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> decode(const std::basic_string<T>& source)
+        static std::basic_string<T> decode(std::type_identity_t<std::basic_string_view<T>> source)
+        {
+            std::size_t errorOffset {};
+            return decode<T>(source, errorOffset);
+        }
+
+
+        /// @brief Base64 decode; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(const std::basic_string<T, Traits, Alloc>& source)
+        {
+            return decode<T>(std::basic_string_view<T>(source));
+        }
+
+
+        /// @brief Base64 decode the given encoded string in the given alphabet back to the binary value
+        /// @param source Previously encoded value. Padding is optional for `Base64Alphabet::UrlSafe`.
+        /// @param alphabet The alphabet of the source
+        /// @return Base64 decoded string; empty if the source is not valid for the alphabet
+        template <typename T = char>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(std::type_identity_t<std::basic_string_view<T>> source, Base64Alphabet alphabet)
+        {
+            std::size_t errorOffset {};
+            return decode<T>(source, errorOffset, alphabet);
+        }
+
+
+        /// @brief Base64 decode in the given alphabet; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(const std::basic_string<T, Traits, Alloc>& source, Base64Alphabet alphabet)
+        {
+            return decode<T>(std::basic_string_view<T>(source), alphabet);
+        }
+
+
+        /// @brief Base64 decode the given encoded string back to the binary value and report where it failed
+        /// @param source Previously encoded value. Must be free of whitespace and padded unless the alphabet is
+        /// `Base64Alphabet::UrlSafe`.
+        /// @param errorOffset Receives the offset of the first character which could not be decoded or
+        /// `Base64Kernels::npos` on success
+        /// @param alphabet The alphabet of the source
+        /// @return Base64 decoded string; empty if the source is not valid base64
+        /// @remarks The exact length is computed from the padding so trailing zero bytes in binary values are preserved.
+        template <typename T = char>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(std::type_identity_t<std::basic_string_view<T>> source,
+                                           std::size_t&                                    errorOffset,
+                                           Base64Alphabet                                  alphabet = Base64Alphabet::Standard)
         {
             if constexpr (std::is_same_v<T, char>) {
-                // The OpenSSL interface only supports char/utf-8
-                uint32_t destSize = 0;
-                // Going from encoded to normal utf results in a "smaller" destination so we
-                // will leave the reservation to same length as the source and resize
-                std::basic_string<T> dest(source.length(), 0);
-
-                if (destSize = EVP_DecodeBlock(reinterpret_cast<unsigned char*>(dest.data()),
-                                               reinterpret_cast<const unsigned char*>(source.data()),
-                                               source.length());
-                    destSize > 0)
-                {
-                    // Remove/trim the padded \0 at the end
-                    // Start from the end and if we see a \0 then decrease the destSize
-                    while ((destSize > 0) && dest.at(destSize - 1) == '\0') {
-                        destSize--;
-                    };
+                std::basic_string<T> dest(Base64Kernels::decodedSize(source.data(), source.length()), 0);
 
-                    dest.resize(destSize);
+                if (auto result = Base64Kernels::decode(
+                            source.data(), source.length(), reinterpret_cast<unsigned char*>(dest.data()), alphabet);
+                    result)
+                {
+                    errorOffset = Base64Kernels::npos;
                     return dest;
                 }
+                else {
+                    errorOffset = result.errorOffset;
+                }
             }
             else {
-                // Convert the source to char from wchar_t
-                // encode as char
-                // Then encode the result back to the wchar_t
-                return ConversionUtils::convert_to<char, wchar_t>(decode<char>(ConversionUtils::convert_to<wchar_t, char>(source)));
+                // Decode and transcode the UTF-8 result in one fused pass; there is never more than one wchar_t per byte so
+                // the output only ever shrinks.
+                std::basic_string<T> dest(Base64Kernels::decodedSize(source.data(), source.length()), 0);
+
+                if (auto result = Base64Kernels::decodeWide(source.data(), source.length(), dest.data(), alphabet); result) {
+                    errorOffset = Base64Kernels::npos;
+                    dest.resize(result.written);
+                    return dest;
+                }
+                else {
+                    errorOffset = result.errorOffset;
+                }
             }
 
             // Fall-through is failure; return empty string
             return {};
         }
+
+
+        /// @brief Base64 decode and report where it failed; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(const std::basic_string<T, Traits, Alloc>& source,
+                                           std::size_t&                                errorOffset,
+                                           Base64Alphabet                              alphabet = Base64Alphabet::Standard)
+        {
+            return decode<T>(std::basic_string_view<T>(source), errorOffset, alphabet);
+        }
+
+
+        /// @brief Exact number of characters produced by encoding `n` bytes
+        /// @param padding When false the trailing `=` are omitted
+        static constexpr std::size_t encodedSize(std::size_t n, bool padding = true) noexcept
+        {
+            return Base64Kernels::encodedSize(n, padding);
+        }
+
+
+        /// @brief Exact number of bytes produced by decoding the (valid) encoded value
+        static constexpr std::size_t decodedSize(std::string_view encoded) noexcept
+        {
+            return Base64Kernels::decodedSize(encoded.data(), encoded.length());
+        }
+
+
+        /// @brief Base64 encode into a caller-provided buffer
+        /// @param source The bytes to encode
+        /// @param dest Must have room for at least `encodedSize(source.size(), padding)` characters
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return Number of characters written
+        /// @throws std::invalid_argument if the destination is too small
+        static std::size_t encodeInto(std::span<const std::byte> source,
+                                      std::span<char>            dest,
+                                      Base64Alphabet             alphabet = Base64Alphabet::Standard,
+                                      bool                       padding  = true)
+        {
+            if (dest.size() < encodedSize(source.size(), padding))
+                throw std::invalid_argument(std::format("Destination requires {} characters; only {} available",
+                                                        encodedSize(source.size(), padding),
+                                                        dest.size()));
+
+            return Base64Kernels::encode(
+                    reinterpret_cast<const unsigned char*>(source.data()), source.size(), dest.data(), alphabet, padding);
+        }
+
+
+        /// @brief Base64 encode and append to the buffer; the buffer grows by exactly the encoded size
+        /// @param source The bytes to encode
+        /// @param dest Buffer to append; for example std::string or std::vector<char>
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return Number of characters appended
+        template <AppendableBuffer B>
+        static std::size_t encodeInto(std::span<const std::byte> source,
+                                      B&                         dest,
+                                      Base64Alphabet             alphabet = Base64Alphabet::Standard,
+                                      bool                       padding  = true)
+        {
+            const auto start = dest.size();
+
+            dest.resize(start + encodedSize(source.size(), padding));
+            return Base64Kernels::encode(reinterpret_cast<const unsigned char*>(source.data()),
+                                         source.size(),
+                                         reinterpret_cast<char*>(dest.data()) + start,
+                                         alphabet,
+                                         padding);
+        }
+
+
+        /// @brief Base64 encode text into a caller-provided buffer; usable in constant expressions
+        /// @param source The text to encode
+        /// @param dest Must have room for at least `encodedSize(source.size(), padding)` characters
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return Number of characters written
+        /// @throws std::invalid_argument if the destination is too small
+        /// @remarks Constant evaluation uses the scalar kernel which produces the same output as the vector kernels.
+        static constexpr std::size_t encodeInto(std::string_view source,
+                                                std::span<char>  dest,
+                                                Base64Alphabet   alphabet = Base64Alphabet::Standard,
+                                                bool             padding  = true)
+        {
+            if (dest.size() < encodedSize(source.size(), padding))
+                throw std::invalid_argument(std::format("Destination requires {} characters; only {} available",
+                                                        encodedSize(source.size(), padding),
+                                                        dest.size()));
+
+            if (std::is_constant_evaluated())
+                return Base64Kernels::encodeScalar(
+                        source.data(), source.size(), dest.data(), Base64Kernels::tables(alphabet), padding);
+
+            return Base64Kernels::encode(
+                    reinterpret_cast<const unsigned char*>(source.data()), source.size(), dest.data(), alphabet, padding);
+        }
+
+
+        /// @brief Base64 encode a string literal or fixed-size array at compile time
+        /// @tparam Alphabet The alphabet to emit
+        /// @tparam Padding Emit the trailing `=`
+        /// @param source String literal; the terminating null is not encoded
+        /// @return The encoded characters (not null terminated)
+        /// @remarks For a compile-time constant JWT header:
+        /// `static constexpr auto header = Base64Utils::encodeFixed<Base64Alphabet::UrlSafe, false>(R"({"alg":"HS256"})");`
+        template <Base64Alphabet Alphabet = Base64Alphabet::Standard, bool Padding = true, std::size_t N>
+        static constexpr std::array<char, Base64Kernels::encodedSize(N - 1, Padding)> encodeFixed(const char (&source)[N]) noexcept
+        {
+            std::array<char, Base64Kernels::encodedSize(N - 1, Padding)> dest {};
+
+            Base64Kernels::encodeScalar(source, N - 1, dest.data(), Base64Kernels::tables(Alphabet), Padding);
+            return dest;
+        }
+
+
+        /// @brief Base64 encode a fixed-size array of bytes at compile time
+        /// @tparam Alphabet The alphabet to emit
+        /// @tparam Padding Emit the trailing `=`
+        /// @param source Array of char, unsigned char or std::byte
+        /// @return The encoded characters (not null terminated)
+        template <Base64Alphabet Alphabet = Base64Alphabet::Standard, bool Padding = true, typename B, std::size_t N>
+            requires(sizeof(B) == 1)
+        static constexpr std::array<char, Base64Kernels::encodedSize(N, Padding)> encodeFixed(const std::array<B, N>& source) noexcept
+        {
+            std::array<char, Base64Kernels::encodedSize(N, Padding)> dest {};
+
+            Base64Kernels::encodeScalar(source.data(), N, dest.data(), Base64Kernels::tables(Alphabet), Padding);
+            return dest;
+        }
+
+
+        /// @brief Base64 decode into a caller-provided buffer; usable in constant expressions
+        /// @param source The encoded value; must be free of whitespace and padded unless the alphabet is `Base64Alphabet::UrlSafe`
+        /// @param dest Must have room for at least `decodedSize(source)` bytes
+        /// @param alphabet The alphabet of the source
+        /// @return The number of bytes written and, on failure, the offset of the offending character
+        /// @throws std::invalid_argument if the destination is too small
+        static constexpr Base64Kernels::DecodeResult
+        decodeInto(std::string_view source, std::span<std::byte> dest, Base64Alphabet alphabet = Base64Alphabet::Standard)
+        {
+            if (dest.size() < decodedSize(source))
+                throw std::invalid_argument(
+                        std::format("Destination requires {} bytes; only {} available", decodedSize(source), dest.size()));
+
+            return Base64Kernels::decode(source.data(),
+                                         source.length(),
+                                         dest.data(),
+                                         alphabet,
+                                         std::is_constant_evaluated() ? Base64Kernels::Kernel::Scalar : Base64Kernels::bestKernel());
+        }
+
+
+        /// @brief Base64 decode text into a caller-provided buffer; usable in constant expressions
+        /// @param source The encoded value; must be free of whitespace and padded unless the alphabet is `Base64Alphabet::UrlSafe`
+        /// @param dest Must have room for at least `decodedSize(source)` characters
+        /// @param alphabet The alphabet of the source
+        /// @return The number of characters written and, on failure, the offset of the offending character
+        /// @throws std::invalid_argument if the destination is too small
+        /// @remarks For a compile-time constant:
+        /// `static constexpr auto key = [] {`
+        /// `    std::array<char, Base64Utils::decodedSize("a2V5")> k {};`
+        /// `    Base64Utils::decodeInto("a2V5", k);`
+        /// `    return k;`
+        /// `}();`
+        static constexpr Base64Kernels::DecodeResult
+        decodeInto(std::string_view source, std::span<char> dest, Base64Alphabet alphabet = Base64Alphabet::Standard)
+        {
+            if (dest.size() < decodedSize(source))
+                throw std::invalid_argument(
+                        std::format("Destination requires {} characters; only {} available", decodedSize(source), dest.size()));
+
+            return Base64Kernels::decode(source.data(),
+                                         source.length(),
+                                         dest.data(),
+                                         alphabet,
+                                         std::is_constant_evaluated() ? Base64Kernels::Kernel::Scalar : Base64Kernels::bestKernel());
+        }
+
+
+        /// @brief Base64 decode and append to the buffer. On failure the buffer is left as it was.
+        /// @param source The encoded value; must be free of whitespace and padded unless the alphabet is `Base64Alphabet::UrlSafe`
+        /// @param dest Buffer to append; for example std::vector<std::byte> or std::string
+        /// @param alphabet The alphabet of the source
+        /// @return The number of bytes appended and, on failure, the offset of the offending character
+        template <AppendableBuffer B>
+        static Base64Kernels::DecodeResult
+        decodeInto(std::string_view source, B& dest, Base64Alphabet alphabet = Base64Alphabet::Standard)
+        {
+            const auto start = dest.size();
+
+            dest.resize(start + decodedSize(source));
+            auto result = Base64Kernels::decode(
+                    source.data(), source.length(), reinterpret_cast<unsigned char*>(dest.data()) + start, alphabet);
+            dest.resize(result ? (start + result.written) : start);
+            return result;
+        }
+
+
+        /// @brief Location of one encoded item within the arena filled by `encodeBatch`
+        struct BatchItem
+        {
+            std::size_t offset {0};
+            std::size_t length {0};
+        };
+
+
+        /// @brief Base64 encode many (small) items contiguously into one arena
+        /// @param items Range of byte sequences; for example std::vector<std::string> or std::vector<std::span<const std::byte>>
+        /// @param arena Buffer to append; grows once by the total encoded size
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @return The offset (within the arena) and length of each encoded item in the order of `items`
+        /// @remarks The kernel is selected once for the batch and every item is encoded straight into its slot; there is
+        /// one allocation for the arena and one for the result regardless of the number of items.
+        template <std::ranges::forward_range R, AppendableBuffer B>
+            requires std::ranges::contiguous_range<std::ranges::range_value_t<R>> &&
+                     (sizeof(std::ranges::range_value_t<std::ranges::range_value_t<R>>) == 1)
+        static std::vector<BatchItem> encodeBatch(const R&       items,
+                                                  B&             arena,
+                                                  Base64Alphabet alphabet = Base64Alphabet::Standard,
+                                                  bool           padding  = true)
+        {
+            std::vector<BatchItem> result;
+            std::size_t            offset = arena.size();
+
+            if constexpr (std::ranges::sized_range<R>) result.reserve(std::ranges::size(items));
+            for (const auto& item : items) {
+                result.push_back({offset, encodedSize(std::ranges::size(item), padding)});
+                offset += result.back().length;
+            }
+
+            arena.resize(offset);
+
+            const auto kernel = Base64Kernels::bestKernel();
+            auto       out    = reinterpret_cast<char*>(arena.data());
+            auto       slot   = result.begin();
+            for (const auto& item : items) {
+                Base64Kernels::encode(reinterpret_cast<const unsigned char*>(std::ranges::data(item)),
+                                      std::ranges::size(item),
+                                      out + (slot++)->offset,
+                                      alphabet,
+                                      padding,
+                                      kernel);
+            }
+
+            return result;
+        }
+
+
+        /// @brief Runs a task; for example by posting it to an existing thread pool. The task must eventually run.
+        using Executor = std::function<void(std::function<void()>)>;
+
+        /// @brief Inputs smaller than this stay on the single-threaded path
+        static constexpr std::size_t ParallelThreshold = 4 * 1024 * 1024;
+
+        /// @brief Unit of work for the parallel paths; a multiple of both 3 (encode) and 4 (decode) sized to stay in L2
+        static constexpr std::size_t ParallelChunkSize = 3 * 4 * 64 * 1024;
+
+
+        /// @brief Base64 encode a large buffer using multiple threads
+        /// @param source The bytes to encode
+        /// @param alphabet The alphabet to emit
+        /// @param padding Emit the trailing `=`
+        /// @param executor Optional executor for the worker tasks; when empty the work runs on internal threads
+        /// @return Base64 encoded string; identical to `encode`
+        /// @remarks The input is split on 3-byte boundaries and each chunk is written straight into its slot in the output.
+        static std::string encodeParallel(std::string_view source,
+                                          Base64Alphabet   alphabet = Base64Alphabet::Standard,
+                                          bool             padding  = true,
+                                          const Executor&  executor = {})
+        {
+            if (source.length() < ParallelThreshold) return encode<char>(source, alphabet, padding);
+
+            std::string dest(encodedSize(source.length(), padding), 0);
+            const auto  chunks = (source.length() + ParallelChunkSize - 1) / ParallelChunkSize;
+
+            runParallel(
+                    chunks,
+                    [&](std::size_t chunk) {
+                        const auto start = chunk * ParallelChunkSize;
+
+                        Base64Kernels::encode(reinterpret_cast<const unsigned char*>(source.data()) + start,
+                                              std::min(ParallelChunkSize, source.length() - start),
+                                              dest.data() + ((start / 3) * 4),
+                                              alphabet,
+                                              padding);
+                    },
+                    executor);
+
+            return dest;
+        }
+
+
+        /// @brief Base64 decode a large encoded value using multiple threads
+        /// @param source Previously encoded value. Must be free of whitespace and padded unless the alphabet is
+        /// `Base64Alphabet::UrlSafe`.
+        /// @param errorOffset Receives the offset of the first character which could not be decoded or
+        /// `Base64Kernels::npos` on success
+        /// @param alphabet The alphabet of the source
+        /// @param executor Optional executor for the worker tasks; when empty the work runs on internal threads
+        /// @return Base64 decoded string; empty if the source is not valid base64. Identical to `decode`.
+        /// @remarks The input is split on 4-character boundaries; the last group (which may be padded) is decoded last.
+        static std::string decodeParallel(std::string_view source,
+                                          std::size_t&     errorOffset,
+                                          Base64Alphabet   alphabet = Base64Alphabet::Standard,
+                                          const Executor&  executor = {})
+        {
+            if (source.length() < ParallelThreshold) return decode<char>(source, errorOffset, alphabet);
+
+            const auto  remainder = source.length() % 4;
+            const auto  body      = source.length() - ((remainder == 0) ? 4 : remainder);
+            const auto  chunks    = (body + ParallelChunkSize - 1) / ParallelChunkSize;
+            std::string dest(decodedSize(source), 0);
+            auto        out = reinterpret_cast<unsigned char*>(dest.data());
+
+            // Chunks may fail in any order; keep the lowest offset
+            std::atomic<std::size_t> firstError {Base64Kernels::npos};
+
+            runParallel(
+                    chunks,
+                    [&](std::size_t chunk) {
+                        const auto start  = chunk * ParallelChunkSize;
+                        auto       result = Base64Kernels::decodeGroups(source.data() + start,
+                                                                  std::min(ParallelChunkSize, body - start),
+                                                                  out + ((start / 4) * 3),
+                                                                  alphabet,
+                                                                  Base64Kernels::bestKernel());
+                        if (!result) {
+                            auto offset = firstError.load();
+                            while ((start + result.errorOffset) < offset &&
+                                   !firstError.compare_exchange_weak(offset, start + result.errorOffset))
+                                ;
+                        }
+                    },
+                    executor);
+
+            errorOffset = firstError.load();
+            if (errorOffset == Base64Kernels::npos) {
+                auto last = Base64Kernels::decode(source.data() + body, source.length() - body, out + ((body / 4) * 3), alphabet);
+                if (last) return dest;
+                errorOffset = body + last.errorOffset;
+            }
+
+            return {};
+        }
+
+
+    private:
+        /// @brief Run `work(0..chunks-1)` on the calling thread and the workers; returns once every chunk is complete
+        /// @remarks The tasks refer to this frame so it never unwinds while one may still run: when the executor (or
+        /// starting a thread) throws, the work is finished here and the queued tasks are waited for before rethrowing.
+        static void runParallel(std::size_t chunks, const std::function<void(std::size_t)>& work, const Executor& executor)
+        {
+            const auto               workers = std::min<std::size_t>(chunks, std::max(1u, std::thread::hardware_concurrency()));
+            std::atomic<std::size_t> next {0};
+            std::latch               done(static_cast<std::ptrdiff_t>(workers - 1));
+
+            // Chunks are handed out in order so neighbouring threads touch neighbouring memory
+            auto drain = [&] {
+                for (auto chunk = next.fetch_add(1); chunk < chunks; chunk = next.fetch_add(1)) work(chunk);
+            };
+            auto task = [&] {
+                drain();
+                done.count_down();
+            };
+
+            std::vector<std::jthread> threads;
+            std::size_t               started = 1;
+            try {
+                for (; started < workers; started++) {
+                    if (executor)
+                        executor(task);
+                    else
+                        threads.emplace_back(task);
+                }
+            }
+            catch (...) {
+                drain();
+                // Account for the tasks which were never queued
+                done.count_down(static_cast<std::ptrdiff_t>(workers - started));
+                done.wait();
+                throw;
+            }
+
+            // The calling thread takes its share rather than idling
+            drain();
+            done.wait();
+        }
     };
 } // namespace siddiqsoft
 #else
@@ -40,3 +40,6 @@
 #elif defined(__unix__) || defined(__APPLE__)
 #   include "base64-utils-unix.hpp"
 #endif
+
+// The streaming encoder/decoder is platform neutral
+#include "base64-stream.hpp"
@@ -0,0 +1,379 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#ifndef COSMOS_TOKEN_CACHE_HPP
+#define COSMOS_TOKEN_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "encryption-utils.hpp"
+#include "shared-snapshot.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /**
+     * @brief Memo of Cosmos authorization tokens for the current second.
+     *        `EncryptionUtils::CosmosToken` depends only on the key and (verb, type, resourceLink, date) and the RFC 7231
+     *        date has one-second resolution, so identical requests within the same second share one signature.
+     * @remarks The entries for the newest date seen and the one before it are kept, so the requests that formatted their
+     *          date just before a tick still find their entries once the first request after it has rolled forward.
+     *          Only a newer date starts a new generation; an older date (a retry, a caller whose clock lags) or one
+     *          which is not an RFC 7231 date is signed without being kept.
+     *          A hit allocates only the returned string: the request is looked up by its views without building a key.
+     *          At most `maxEntries` signatures are held per second; beyond that tokens are signed but not kept.
+     */
+    class CosmosTokenCache
+    {
+    public:
+        /// @brief Lookup counters since construction
+        struct Statistics
+        {
+            std::uint64_t hits;
+            std::uint64_t misses;
+        };
+
+
+        /// @brief Create an empty cache for the key
+        /// @param key Binary. The key must be decoded from the base64 value in the connection string from the Azure portal
+        /// @param maxEntries The most signatures held for any one second
+        explicit CosmosTokenCache(std::string_view key, std::size_t maxEntries = 4096)
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(WIN64)
+            : signingKey(key)
+#else
+            // The key schedule is absorbed once; an empty key is reported by `get` as `EncryptionUtils::CosmosToken` does
+            : signer(key.empty() ? std::nullopt : std::make_optional<NativeHmacSha256Signer>(key))
+#endif
+            , capacity(maxEntries)
+        {
+        }
+
+
+        /// @brief The Cosmos authorization token; identical to `EncryptionUtils::CosmosToken`
+        /// @param verb GET, POST, PUT, DELETE
+        /// @param type One of the following: dbs, docs, colls, attachments or empty
+        /// @param resourceLink The resource link sub-uri
+        /// @param date Date in RFC7231 as string
+        /// @throws std::invalid_argument as `EncryptionUtils::CosmosToken` when the key, verb or date is empty
+        std::string get(std::string_view verb, std::string_view type, std::string_view resourceLink, std::string_view date)
+        {
+            auto generation = find(generations.load(), date);
+            if (!generation) generation = rollover(date);
+
+            if (!generation) {
+                misses.fetch_add(1, std::memory_order_relaxed);
+                return sign(verb, type, resourceLink, date);
+            }
+
+            const Request request {verb, type, resourceLink};
+            auto&         shard = generation->shards[shardOf(RequestHash {}(request))];
+            {
+                std::shared_lock lock(shard.lock);
+                if (auto it = shard.tokens.find(request); it != shard.tokens.end()) {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    return it->second;
+                }
+            }
+
+            misses.fetch_add(1, std::memory_order_relaxed);
+            auto token = sign(verb, type, resourceLink, date);
+
+            if (generation->count.fetch_add(1, std::memory_order_relaxed) < capacity) {
+                std::scoped_lock lock(shard.lock);
+                shard.tokens.try_emplace(canonical(request), token);
+            }
+
+            return token;
+        }
+
+
+        /// @brief Lookup counters since construction
+        Statistics statistics() const noexcept
+        {
+            return {hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed)};
+        }
+
+
+        /// @brief Number of signatures held for the current second
+        std::size_t size() const
+        {
+            std::size_t count = 0;
+
+            if (auto snapshot = generations.load(); snapshot && snapshot->current) {
+                for (auto& shard : snapshot->current->shards) {
+                    std::shared_lock lock(shard.lock);
+                    count += shard.tokens.size();
+                }
+            }
+            return count;
+        }
+
+    private:
+        static constexpr std::size_t ShardCount = 16;
+
+        /// @brief The shard from the upper bits of the hash; the maps within a shard bucket by the lower bits
+        static constexpr std::size_t shardOf(std::size_t hash) noexcept { return (hash >> 28) % ShardCount; }
+
+        /// @brief The request as passed to `get`; the verb and type are matched in lowercase as they are signed
+        struct Request
+        {
+            std::string_view verb;
+            std::string_view type;
+            std::string_view resourceLink;
+        };
+
+
+        static constexpr char lowerCase(char ch) noexcept
+        {
+            return ((ch >= 'A') && (ch <= 'Z')) ? static_cast<char>(ch + ('a' - 'A')) : ch;
+        }
+
+
+        /// @brief The stored key: "verb\ntype\nresourceLink" with the verb and type in lowercase
+        static std::string canonical(const Request& request)
+        {
+            std::string key;
+
+            key.reserve(request.verb.length() + request.type.length() + request.resourceLink.length() + 2);
+            for (auto ch : request.verb) key.push_back(lowerCase(ch));
+            key.push_back('\n');
+            for (auto ch : request.type) key.push_back(lowerCase(ch));
+            key.push_back('\n');
+            key.append(request.resourceLink);
+            return key;
+        }
+
+
+        /// @brief FNV-1a over the canonical form; a `Request` hashes as the stored key it matches
+        struct RequestHash
+        {
+            using is_transparent = void;
+
+            static constexpr std::uint64_t Basis = 0xcbf29ce484222325;
+            static constexpr std::uint64_t Prime = 0x100000001b3;
+
+            static constexpr std::uint64_t mix(std::uint64_t h, char ch) noexcept
+            {
+                return (h ^ static_cast<unsigned char>(ch)) * Prime;
+            }
+
+            std::size_t operator()(std::string_view key) const noexcept
+            {
+                std::uint64_t h = Basis;
+                for (auto ch : key) h = mix(h, ch);
+                return static_cast<std::size_t>(h);
+            }
+
+            std::size_t operator()(const Request& request) const noexcept
+            {
+                std::uint64_t h = Basis;
+                for (auto ch : request.verb) h = mix(h, lowerCase(ch));
+                h = mix(h, '\n');
+                for (auto ch : request.type) h = mix(h, lowerCase(ch));
+                h = mix(h, '\n');
+                for (auto ch : request.resourceLink) h = mix(h, ch);
+                return static_cast<std::size_t>(h);
+            }
+        };
+
+
+        struct RequestEqual
+        {
+            using is_transparent = void;
+
+            bool operator()(std::string_view a, std::string_view b) const noexcept { return a == b; }
+
+            bool operator()(const Request& request, std::string_view key) const noexcept
+            {
+                if (key.length() != (request.verb.length() + request.type.length() + request.resourceLink.length() + 2))
+                    return false;
+
+                auto lowerMatches = [&key](std::string_view part) {
+                    for (std::size_t i = 0; i < part.length(); i++) {
+                        if (lowerCase(part[i]) != key[i]) return false;
+                    }
+                    key.remove_prefix(part.length());
+                    return key.starts_with('\n') && (key.remove_prefix(1), true);
+                };
+
+                return lowerMatches(request.verb) && lowerMatches(request.type) && (key == request.resourceLink);
+            }
+
+            bool operator()(std::string_view key, const Request& request) const noexcept { return (*this)(request, key); }
+        };
+
+
+        /// @brief Aligned so the writers of neighbouring shards do not share a cache line
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex                                                lock;
+            std::unordered_map<std::string, std::string, RequestHash, RequestEqual> tokens;
+        };
+
+        /// @brief The signatures for one date
+        struct Generation
+        {
+            std::string                   date;
+            std::chrono::sys_seconds      timestamp;
+            std::array<Shard, ShardCount> shards;
+            /// @brief Signatures issued for this date; bounds the footprint
+            std::atomic<std::size_t> count {0};
+        };
+
+        /// @brief The generation for the newest date and the one it replaced
+        struct Generations
+        {
+            std::shared_ptr<Generation> current;
+            std::shared_ptr<Generation> previous;
+        };
+
+
+        /// @brief The instant of an RFC 7231 date ("Thu, 27 Apr 2017 00:51:12 GMT") or nullopt if malformed
+        static std::optional<std::chrono::sys_seconds> parseDate(std::string_view date) noexcept
+        {
+            static constexpr std::string_view Months {"JanFebMarAprMayJunJulAugSepOctNovDec"};
+
+            if ((date.length() != 29) || (date.substr(3, 2) != ", ") || (date[7] != ' ') || (date[11] != ' ') ||
+                (date[16] != ' ') || (date[19] != ':') || (date[22] != ':') || (date.substr(25) != " GMT"))
+                return std::nullopt;
+
+            auto number = [date](std::size_t offset, std::size_t digits) {
+                int value = 0;
+                for (auto ch : date.substr(offset, digits)) {
+                    if ((ch < '0') || (ch > '9')) return -1;
+                    value = (value * 10) + (ch - '0');
+                }
+                return value;
+            };
+
+            const auto month  = Months.find(date.substr(8, 3));
+            const auto day    = number(5, 2);
+            const auto year   = number(12, 4);
+            const auto hour   = number(17, 2);
+            const auto minute = number(20, 2);
+            const auto second = number(23, 2);
+
+            if ((month == std::string_view::npos) || ((month % 3) != 0) || (day < 0) || (year < 0) || (hour < 0) ||
+                (hour > 23) || (minute < 0) || (minute > 59) || (second < 0) || (second > 60))
+                return std::nullopt;
+
+            const std::chrono::year_month_day ymd {std::chrono::year {year},
+                                                   std::chrono::month {static_cast<unsigned>((month / 3) + 1)},
+                                                   std::chrono::day {static_cast<unsigned>(day)}};
+            if (!ymd.ok()) return std::nullopt;
+
+            return std::chrono::sys_days {ymd} + std::chrono::hours {hour} + std::chrono::minutes {minute} +
+                   std::chrono::seconds {second};
+        }
+
+
+        /// @brief The generation in the snapshot for the date or nullptr
+        static std::shared_ptr<Generation> find(const std::shared_ptr<const Generations>& snapshot, std::string_view date)
+        {
+            if (snapshot) {
+                if (snapshot->current && (snapshot->current->date == date)) return snapshot->current;
+                if (snapshot->previous && (snapshot->previous->date == date)) return snapshot->previous;
+            }
+            return nullptr;
+        }
+
+
+        /// @brief Publish an empty generation for a date newer than the current one (which becomes the previous) unless
+        /// another caller already has
+        /// @return nullptr if the date is older than the current generation or malformed; the token is not to be kept
+        std::shared_ptr<Generation> rollover(std::string_view date)
+        {
+            const auto timestamp = parseDate(date);
+            if (!timestamp) return nullptr;
+
+            std::scoped_lock lock(rolloverLock);
+
+            auto snapshot = generations.load();
+            if (auto generation = find(snapshot, date); generation) return generation;
+            if (snapshot && snapshot->current && (*timestamp <= snapshot->current->timestamp)) return nullptr;
+
+            auto generation       = std::make_shared<Generation>();
+            generation->date      = date;
+            generation->timestamp = *timestamp;
+            generations.store(std::make_shared<const Generations>(generation, snapshot ? snapshot->current : nullptr));
+            return generation;
+        }
+
+
+        /// @throws std::invalid_argument as `EncryptionUtils::CosmosToken` when the key, verb or date is empty
+        std::string sign(std::string_view verb, std::string_view type, std::string_view resourceLink, std::string_view date) const
+        {
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(WIN64)
+            // The Windows CosmosToken takes std::string arguments
+            return EncryptionUtils::CosmosToken<char>(
+                    signingKey, std::string(verb), std::string(type), std::string(resourceLink), std::string(date));
+#else
+            if (!signer) throw std::invalid_argument("CosmosToken: key may not be empty");
+
+            std::array<char, EncryptionUtils::CosmosTokenSize> token;
+            return std::string(EncryptionUtils::CosmosToken(*signer, verb, type, resourceLink, date, token));
+#endif
+        }
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(WIN64)
+        std::string signingKey;
+#else
+        std::optional<NativeHmacSha256Signer> signer;
+#endif
+        std::size_t                       capacity;
+        SharedSnapshot<const Generations> generations;
+        std::mutex                        rolloverLock;
+        std::atomic<std::uint64_t>        hits {0};
+        std::atomic<std::uint64_t>        misses {0};
+    };
+} // namespace siddiqsoft
+
+#endif // !COSMOS_TOKEN_CACHE_HPP
@@ -0,0 +1,151 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#ifndef CPU_FEATURES_HPP
+#define CPU_FEATURES_HPP
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIDDIQSOFT_X86_64 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+// GCC and Clang only allow the use of an instruction set extension inside functions that have been
+// explicitly enabled for it (unless the whole translation unit is compiled with -mavx2 etc.).
+// MSVC allows the intrinsics anywhere so the macro expands to nothing.
+#if defined(SIDDIQSOFT_X86_64) && (defined(__GNUC__) || defined(__clang__))
+#define SIDDIQSOFT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIDDIQSOFT_TARGET(isa)
+#endif
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Runtime detection of the instruction set extensions used by the vectorized kernels.
+    ///        The detection runs once per process; use `CpuFeatures::current()` to query.
+    struct CpuFeatures
+    {
+        bool sse41 {false};
+        bool avx2 {false};
+        bool avx512bw {false};
+        bool avx512vbmi {false};
+        bool sha {false};
+        bool pclmul {false};
+        bool vpclmul {false};
+
+        /// @brief The features of the CPU we're running on; cached on first use
+        /// @return Reference to the process-wide feature set
+        static const CpuFeatures& current() noexcept
+        {
+            static const CpuFeatures features {detect()};
+            return features;
+        }
+
+    private:
+        static CpuFeatures detect() noexcept
+        {
+            CpuFeatures features {};
+
+#if defined(SIDDIQSOFT_X86_64)
+            uint32_t regs0[4] {};
+            uint32_t regs1[4] {};
+            uint32_t regs7[4] {};
+
+            cpuid(regs0, 0, 0);
+            cpuid(regs1, 1, 0);
+            if (regs0[0] >= 7) cpuid(regs7, 7, 0);
+
+            const bool ssse3 = (regs1[2] & (1u << 9)) != 0;
+            features.sse41   = ssse3 && ((regs1[2] & (1u << 19)) != 0);
+            features.pclmul  = (regs1[2] & (1u << 1)) != 0;
+            features.sha     = features.sse41 && ((regs7[1] & (1u << 29)) != 0);
+
+            // The AVX family also requires the operating system to save the wider register state
+            if (const bool osxsave = (regs1[2] & (1u << 27)) != 0; osxsave && ((regs1[2] & (1u << 28)) != 0)) {
+                const uint64_t xcr0 = xgetbv();
+
+                if ((xcr0 & 0x06) == 0x06) {
+                    features.avx2    = (regs7[1] & (1u << 5)) != 0;
+                    features.vpclmul = features.avx2 && features.pclmul && ((regs7[2] & (1u << 10)) != 0);
+                }
+
+                if ((xcr0 & 0xe6) == 0xe6) {
+                    const bool avx512f  = (regs7[1] & (1u << 16)) != 0;
+                    features.avx512bw   = avx512f && ((regs7[1] & (1u << 30)) != 0);
+                    features.avx512vbmi = features.avx512bw && ((regs7[2] & (1u << 1)) != 0);
+                }
+            }
+#endif
+
+            return features;
+        }
+
+#if defined(SIDDIQSOFT_X86_64)
+        static void cpuid(uint32_t (&regs)[4], uint32_t leaf, uint32_t subleaf) noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4] {};
+            __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(info[i]);
+#else
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        }
+
+        static uint64_t xgetbv() noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            return _xgetbv(0);
+#else
+            uint32_t eax {}, edx {};
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+        }
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !CPU_FEATURES_HPP
@@ -0,0 +1,357 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef CRC64_UTILS_HPP
+#define CRC64_UTILS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "base64-kernels.hpp"
+#include "cpu-features.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief CRC-64 as used by Azure Storage for transactional integrity (`x-ms-content-crc64`).
+    ///        The reflected polynomial 0x9A6C9329AC4BC9B5 with the register initialized and finalized by inversion
+    ///        (also known as CRC-64/NVME); the check value of "123456789" is 0xAE8B14860A799888.
+    ///        Slicing-by-8 tables are always available; the PCLMULQDQ and VPCLMULQDQ kernels fold 128 and 256 bytes per
+    ///        round and are selected at runtime based on `CpuFeatures`. Every kernel produces the same CRC.
+    /// @remarks `update` continues a CRC so a payload may be processed in any number of pieces and `combine` joins the
+    ///          CRCs of pieces hashed independently (for example on several cores) without reading the data again.
+    struct Crc64Utils
+    {
+        /// @brief The available kernel implementations
+        enum class Kernel
+        {
+            Scalar,
+            PCLMUL,
+            VPCLMUL
+        };
+
+
+        /// @brief The polynomial in reflected (least significant bit first) form
+        static constexpr std::uint64_t Polynomial = 0x9a6c9329ac4bc9b5;
+
+
+        static bool isSupported(Kernel kernel) noexcept
+        {
+            const auto& cpu = CpuFeatures::current();
+
+            switch (kernel) {
+                case Kernel::Scalar: return true;
+#if defined(SIDDIQSOFT_X86_64)
+                case Kernel::PCLMUL: return cpu.pclmul && cpu.sse41;
+                case Kernel::VPCLMUL: return cpu.vpclmul;
+#endif
+                default: return false;
+            }
+        }
+
+
+        /// @brief The fastest kernel supported by this CPU; determined once per process
+        static Kernel bestKernel() noexcept
+        {
+            static const Kernel kernel = [] {
+                if (isSupported(Kernel::VPCLMUL)) return Kernel::VPCLMUL;
+                if (isSupported(Kernel::PCLMUL)) return Kernel::PCLMUL;
+                return Kernel::Scalar;
+            }();
+
+            return kernel;
+        }
+
+
+        /// @brief Continue the CRC over `n` more bytes
+        /// @param crc The CRC of the preceding bytes; 0 to start
+        /// @param kernel The kernel must be supported by this CPU (see `isSupported`)
+        /// @return The CRC of the preceding bytes followed by these
+        static std::uint64_t
+        update(std::uint64_t crc, const unsigned char* data, std::size_t n, Kernel kernel = bestKernel()) noexcept
+        {
+            std::uint64_t reg      = ~crc;
+            std::size_t   consumed = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            switch (kernel) {
+                case Kernel::VPCLMUL: consumed = updateBlocksVPCLMUL(reg, data, n); break;
+                case Kernel::PCLMUL: consumed = updateBlocksPCLMUL(reg, data, n); break;
+                default: break;
+            }
+#endif
+
+            // The vector kernels leave the bytes after the last whole block
+            return ~updateScalar(reg, data + consumed, n - consumed);
+        }
+
+
+        /// @brief Continue the CRC over more bytes
+        /// @param crc The CRC of the preceding bytes; 0 to start
+        static std::uint64_t update(std::uint64_t crc, std::span<const std::byte> data) noexcept
+        {
+            return update(crc, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+        }
+
+
+        /// @brief The CRC of the bytes
+        static std::uint64_t compute(std::span<const std::byte> data) noexcept { return update(0, data); }
+
+
+        /// @brief The CRC of the bytes held in the string
+        static std::uint64_t compute(std::string_view data) noexcept { return update(0, std::as_bytes(std::span(data))); }
+
+
+        /// @brief The CRC of two consecutive pieces from the CRC of each
+        /// @param crc1 The CRC of the first piece
+        /// @param crc2 The CRC of the second piece
+        /// @param length2 Length in bytes of the second piece
+        /// @return The CRC of the first piece followed by the second
+        static constexpr std::uint64_t combine(std::uint64_t crc1, std::uint64_t crc2, std::uint64_t length2) noexcept
+        {
+            // Appending the second piece multiplies the first CRC by x^(8 * length2); the inversions cancel out
+            return multiplyModulo(powerOfX(length2, 3), crc1) ^ crc2;
+        }
+
+
+        /// @brief The value of the `x-ms-content-crc64` header: base64 of the CRC in little-endian byte order
+        static std::string encodeHeader(std::uint64_t crc)
+        {
+            unsigned char bytes[8];
+            std::string   header(Base64Kernels::encodedSize(sizeof(bytes)), 0);
+
+            for (std::size_t i = 0; i < sizeof(bytes); i++) bytes[i] = static_cast<unsigned char>(crc >> (i * 8));
+            Base64Kernels::encode(bytes, sizeof(bytes), header.data());
+            return header;
+        }
+
+    private:
+        // The polynomials are held reflected: bit 63 is the coefficient of x^0 and bit 0 that of x^63.
+
+        /// @brief a * b modulo the polynomial
+        static constexpr auto multiplyModulo = [](std::uint64_t a, std::uint64_t b) {
+            std::uint64_t product = 0;
+
+            // Walk the coefficients of `a` from x^0 upwards while `b` is multiplied by x
+            for (std::uint64_t bit = std::uint64_t {1} << 63; bit != 0; bit >>= 1) {
+                if (a & bit) product ^= b;
+                b = (b & 1) ? ((b >> 1) ^ Polynomial) : (b >> 1);
+            }
+            return product;
+        };
+
+
+        /// @brief x^(2^k) modulo the polynomial for k in [0, 67); enough for x^(8 * n) for any 64-bit n
+        static constexpr std::array<std::uint64_t, 67> PowersOfX = [] {
+            std::array<std::uint64_t, 67> powers {};
+
+            powers[0] = std::uint64_t {1} << 62;
+            for (std::size_t k = 1; k < powers.size(); k++) powers[k] = multiplyModulo(powers[k - 1], powers[k - 1]);
+            return powers;
+        }();
+
+
+        /// @brief x^(n * 2^k) modulo the polynomial
+        static constexpr auto powerOfX = [](std::uint64_t n, std::size_t k = 0) {
+            std::uint64_t power = std::uint64_t {1} << 63;
+
+            for (; n != 0; n >>= 1, k++) {
+                if (n & 1) power = multiplyModulo(PowersOfX[k], power);
+            }
+            return power;
+        };
+
+
+        /// @brief The slicing-by-8 tables; `Tables[k][b]` is the register contribution of byte value b followed by k zeros
+        static constexpr std::array<std::array<std::uint64_t, 256>, 8> Tables = [] {
+            std::array<std::array<std::uint64_t, 256>, 8> tables {};
+
+            for (std::uint64_t i = 0; i < 256; i++) {
+                std::uint64_t reg = i;
+                for (int bit = 0; bit < 8; bit++) reg = (reg & 1) ? ((reg >> 1) ^ Polynomial) : (reg >> 1);
+                tables[0][i] = reg;
+            }
+            for (std::size_t k = 1; k < tables.size(); k++) {
+                for (std::size_t i = 0; i < 256; i++) {
+                    tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+                }
+            }
+            return tables;
+        }();
+
+
+        /// @brief Advance the (uninverted) register over the bytes
+        static std::uint64_t updateScalar(std::uint64_t reg, const unsigned char* src, std::size_t n) noexcept
+        {
+            for (; n >= 8; n -= 8, src += 8) {
+                for (std::size_t i = 0; i < 8; i++) reg ^= static_cast<std::uint64_t>(src[i]) << (i * 8);
+
+                reg = Tables[7][reg & 0xff] ^ Tables[6][(reg >> 8) & 0xff] ^ Tables[5][(reg >> 16) & 0xff] ^
+                      Tables[4][(reg >> 24) & 0xff] ^ Tables[3][(reg >> 32) & 0xff] ^ Tables[2][(reg >> 40) & 0xff] ^
+                      Tables[1][(reg >> 48) & 0xff] ^ Tables[0][reg >> 56];
+            }
+
+            for (; n > 0; n--) reg = Tables[0][(reg ^ *src++) & 0xff] ^ (reg >> 8);
+            return reg;
+        }
+
+#if defined(SIDDIQSOFT_X86_64)
+        // The folding follows Gopal et al., "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+        // (Intel, 2009). A 16-byte block loaded little-endian holds its first eight bytes (the higher-order coefficients H)
+        // in the low quadword and the next eight (L) in the high quadword. Moving the block d bits further along the
+        // message multiplies H by x^(d + 64) and L by x^d; as the carry-less product of two reflected values comes out
+        // multiplied by x the constants are one power lower.
+
+        /// @brief The constants that move a block `blocks` * 128 bits along: x^(d + 63) and x^(d - 1)
+        static constexpr std::array<std::array<std::uint64_t, 2>, 17> FoldConstants = [] {
+            std::array<std::array<std::uint64_t, 2>, 17> constants {};
+
+            for (std::uint64_t blocks = 1; blocks < constants.size(); blocks++) {
+                constants[blocks] = {powerOfX((blocks * 128) + 63), powerOfX((blocks * 128) - 1)};
+            }
+            return constants;
+        }();
+
+
+        static __m128i foldConstants(std::size_t blocks) noexcept
+        {
+            return _mm_set_epi64x(static_cast<long long>(FoldConstants[blocks][1]),
+                                  static_cast<long long>(FoldConstants[blocks][0]));
+        }
+
+
+        SIDDIQSOFT_TARGET("pclmul,sse4.1")
+        static __m128i foldPCLMUL(__m128i block, __m128i constants) noexcept
+        {
+            return _mm_xor_si128(_mm_clmulepi64_si128(block, constants, 0x00), _mm_clmulepi64_si128(block, constants, 0x11));
+        }
+
+
+        /// @brief Fold the consecutive accumulators into the last, absorb the remaining whole blocks of the source and
+        ///        reduce the result to the register
+        /// @return Number of source bytes consumed
+        SIDDIQSOFT_TARGET("pclmul,sse4.1")
+        static std::size_t
+        finishPCLMUL(std::uint64_t& reg, const __m128i* blocks, std::size_t count, const unsigned char* src, std::size_t n) noexcept
+        {
+            __m128i     last     = blocks[count - 1];
+            std::size_t consumed = 0;
+
+            for (std::size_t i = 0; (i + 1) < count; i++) {
+                last = _mm_xor_si128(last, foldPCLMUL(blocks[i], foldConstants(count - 1 - i)));
+            }
+
+            for (const __m128i next = foldConstants(1); (n - consumed) >= 16; consumed += 16) {
+                last = _mm_xor_si128(foldPCLMUL(last, next), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed)));
+            }
+
+            // The CRC of the message equals the CRC of any 128-bit value congruent to it
+            alignas(16) unsigned char remainder[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(remainder), last);
+            reg = updateScalar(0, remainder, sizeof(remainder));
+            return consumed;
+        }
+
+
+        /// @return Number of source bytes consumed; 0 when there are fewer than 128
+        SIDDIQSOFT_TARGET("pclmul,sse4.1")
+        static std::size_t updateBlocksPCLMUL(std::uint64_t& reg, const unsigned char* src, std::size_t n) noexcept
+        {
+            if (n < 128) return 0;
+
+            // Eight independent accumulators each move 1024 bits per round
+            const __m128i constants = foldConstants(8);
+            __m128i       blocks[8];
+            std::size_t   consumed = 128;
+
+            for (std::size_t i = 0; i < 8; i++) blocks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (i * 16)));
+            blocks[0] = _mm_xor_si128(blocks[0], _mm_cvtsi64_si128(static_cast<long long>(reg)));
+
+            for (; (n - consumed) >= 128; consumed += 128) {
+                for (std::size_t i = 0; i < 8; i++) {
+                    blocks[i] = _mm_xor_si128(foldPCLMUL(blocks[i], constants),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed + (i * 16))));
+                }
+            }
+
+            return consumed + finishPCLMUL(reg, blocks, 8, src + consumed, n - consumed);
+        }
+
+
+        /// @return Number of source bytes consumed; 0 when there are fewer than 128
+        SIDDIQSOFT_TARGET("avx2,pclmul,vpclmulqdq")
+        static std::size_t updateBlocksVPCLMUL(std::uint64_t& reg, const unsigned char* src, std::size_t n) noexcept
+        {
+            if (n < 256) return updateBlocksPCLMUL(reg, src, n);
+
+            // Eight accumulators of two blocks each move 2048 bits per round
+            const __m256i constants = _mm256_broadcastsi128_si256(foldConstants(16));
+            __m256i       lanes[8];
+            __m128i       blocks[16];
+            std::size_t   consumed = 256;
+
+            for (std::size_t i = 0; i < 8; i++) lanes[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (i * 32)));
+            lanes[0] = _mm256_xor_si256(lanes[0], _mm256_set_epi64x(0, 0, 0, static_cast<long long>(reg)));
+
+            for (; (n - consumed) >= 256; consumed += 256) {
+                for (std::size_t i = 0; i < 8; i++) {
+                    const __m256i folded = _mm256_xor_si256(_mm256_clmulepi64_epi128(lanes[i], constants, 0x00),
+                                                            _mm256_clmulepi64_epi128(lanes[i], constants, 0x11));
+                    lanes[i] = _mm256_xor_si256(folded,
+                                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + consumed + (i * 32))));
+                }
+            }
+
+            for (std::size_t i = 0; i < 8; i++) {
+                blocks[i * 2]       = _mm256_castsi256_si128(lanes[i]);
+                blocks[(i * 2) + 1] = _mm256_extracti128_si256(lanes[i], 1);
+            }
+
+            return consumed + finishPCLMUL(reg, blocks, 16, src + consumed, n - consumed);
+        }
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !CRC64_UTILS_HPP
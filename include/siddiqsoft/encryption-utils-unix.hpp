@@ -50,22 +50,389 @@
 #include <ranges>
 #include <concepts>
 #include <format>
+#include <span>
+#include <string_view>
+#include <cstddef>
+#include <array>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 
 #include "siddiqsoft/conversion-utils.hpp"
 #include "base64-utils.hpp"
+#include "hex-utils.hpp"
 #include "url-utils.hpp"
+#include "sha256-kernels.hpp"
 #include "siddiqsoft/RunOnEnd.hpp"
 
 #include "openssl/evp.h"
 #include "openssl/md5.h"
 #include "openssl/hmac.h"
 #include "openssl/params.h"
+#include "openssl/core_names.h"
 #include "openssl/err.h"
 
 
 /// @brief SiddiqSoft
 namespace siddiqsoft
 {
+    /// @brief Digest algorithms for `EncryptionUtils::calcDigest`
+    enum class DigestType
+    {
+        MD4,
+        MD5,
+        SHA1,
+        SHA256,
+        SHA512
+    };
+
+
+    /// @brief How `EncryptionUtils::calcDigest`, `EncryptionUtils::MD5` and `Digest::final` present the digest
+    enum class DigestFormat
+    {
+        /// @brief The binary digest enclosed in string
+        Raw,
+        /// @brief Lowercase hex characters
+        Hex,
+        /// @brief Uppercase hex characters
+        UpperHex,
+        /// @brief Base64 of the binary digest; for example the value of the Content-MD5 header
+        Base64
+    };
+
+
+    /**
+     * @brief Process-wide cache of the OpenSSL 3 algorithm objects.
+     *        Resolving an algorithm by name (`EVP_get_digestbyname`, one-shot `HMAC`) goes through the provider lookup
+     *        and its global locks on every call; here each algorithm is fetched once, on first use, and shared.
+     * @remarks Initialization is thread-safe (function-local statics). The objects are read-only once fetched.
+     */
+    struct OpenSslAlgorithms
+    {
+        /// @brief The fetched digest or nullptr if no loaded provider implements it (for example MD4 without the legacy
+        /// provider)
+        static const EVP_MD* digest(DigestType type) noexcept
+        {
+            using FetchedDigest = std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)>;
+
+            static const std::array<FetchedDigest, 5> digests {FetchedDigest(EVP_MD_fetch(NULL, "MD4", NULL), &EVP_MD_free),
+                                                               FetchedDigest(EVP_MD_fetch(NULL, "MD5", NULL), &EVP_MD_free),
+                                                               FetchedDigest(EVP_MD_fetch(NULL, "SHA1", NULL), &EVP_MD_free),
+                                                               FetchedDigest(EVP_MD_fetch(NULL, "SHA256", NULL), &EVP_MD_free),
+                                                               FetchedDigest(EVP_MD_fetch(NULL, "SHA512", NULL), &EVP_MD_free)};
+
+            return digests[static_cast<std::size_t>(type)].get();
+        }
+
+
+        /// @brief The fetched HMAC algorithm or nullptr if no loaded provider implements it
+        static EVP_MAC* hmac() noexcept
+        {
+            static const std::unique_ptr<EVP_MAC, decltype(&EVP_MAC_free)> mac(EVP_MAC_fetch(NULL, "HMAC", NULL), &EVP_MAC_free);
+
+            return mac.get();
+        }
+
+
+        /// @brief A keyless HMAC context with the SHA-256 digest already set or nullptr if HMAC-SHA256 is not available.
+        ///        Duplicate it (`EVP_MAC_CTX_dup`) and initialize the copy with the key and no parameters; passing the
+        ///        digest name to `EVP_MAC_init` would fetch the digest by name again on every call.
+        static const EVP_MAC_CTX* hmacSha256() noexcept
+        {
+            using MacContext = std::unique_ptr<EVP_MAC_CTX, decltype(&EVP_MAC_CTX_free)>;
+
+            static const MacContext ctx = [] {
+                MacContext result(hmac() != nullptr ? EVP_MAC_CTX_new(hmac()) : nullptr, &EVP_MAC_CTX_free);
+
+                char       digestName[] = "SHA256";
+                OSSL_PARAM params[]     = {OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digestName, 0),
+                                           OSSL_PARAM_construct_end()};
+
+                if (result && !EVP_MAC_CTX_set_params(result.get(), params)) result.reset();
+                return result;
+            }();
+
+            return ctx.get();
+        }
+
+
+        /// @brief The fetched digest by name or nullptr if no loaded provider implements it.
+        ///        For the names without a `DigestType` (for example "MD5-SHA1"); each name is fetched once.
+        static const EVP_MD* digest(std::string_view name)
+        {
+            using FetchedDigest = std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)>;
+
+            static std::shared_mutex                                 digestsLock;
+            static std::map<std::string, FetchedDigest, std::less<>> digests;
+
+            {
+                std::shared_lock<std::shared_mutex> readers(digestsLock);
+                if (auto it = digests.find(name); it != digests.end()) return it->second.get();
+            }
+
+            std::unique_lock<std::shared_mutex> writer(digestsLock);
+            if (auto it = digests.find(name); it != digests.end()) return it->second.get();
+
+            FetchedDigest fetched(EVP_MD_fetch(NULL, std::string(name).c_str(), NULL), &EVP_MD_free);
+            if (!fetched) return nullptr;
+            return digests.emplace(std::string(name), std::move(fetched)).first->second.get();
+        }
+    };
+
+
+    /**
+     * @brief HMAC-SHA256 backend using OpenSSL (`EVP_MAC`).
+     *        The keyed state is an `EVP_MAC_CTX`; each signature duplicates it and finalizes.
+     */
+    struct OpenSslHmacSha256
+    {
+        /// @brief The keyed context
+        using KeyState = std::unique_ptr<EVP_MAC_CTX, decltype(&EVP_MAC_CTX_free)>;
+
+
+        /// @throws std::runtime_error if OpenSSL cannot provide HMAC-SHA256
+        static KeyState absorbKey(std::span<const std::byte> key)
+        {
+            const auto keyless = OpenSslAlgorithms::hmacSha256();
+            if (keyless == nullptr) throw std::runtime_error("HmacSha256Signer: HMAC is not available");
+
+            KeyState ctx(EVP_MAC_CTX_dup(keyless), &EVP_MAC_CTX_free);
+
+            if (!ctx || !EVP_MAC_init(ctx.get(), reinterpret_cast<const unsigned char*>(key.data()), key.size(), NULL))
+                throw std::runtime_error("HmacSha256Signer: failed to initialize HMAC-SHA256");
+            return ctx;
+        }
+
+
+        /// @throws std::runtime_error if OpenSSL fails
+        static void sign(const KeyState& ctx, std::span<const std::byte> message, std::span<std::byte, 32> dest)
+        {
+            KeyState    work(EVP_MAC_CTX_dup(ctx.get()), &EVP_MAC_CTX_free);
+            std::size_t written = 0;
+
+            if (!work || !EVP_MAC_update(work.get(), reinterpret_cast<const unsigned char*>(message.data()), message.size()) ||
+                !EVP_MAC_final(work.get(), reinterpret_cast<unsigned char*>(dest.data()), &written, dest.size()))
+                throw std::runtime_error("HmacSha256Signer: failed to sign");
+        }
+    };
+
+
+    /**
+     * @brief HMAC-SHA256 backend using the built-in `Sha256Kernels`.
+     *        The SHA extensions are used when the CPU has them and portable code otherwise. For the 60-200 byte strings
+     *        signed for Cosmos and SAS this avoids the allocation and provider dispatch of every OpenSSL call.
+     */
+    struct NativeHmacSha256
+    {
+        /// @brief The hash states after the inner and outer key blocks
+        using KeyState = Sha256Kernels::HmacKey;
+
+
+        static KeyState absorbKey(std::span<const std::byte> key) noexcept { return Sha256Kernels::hmacKey(key); }
+
+
+        static void sign(const KeyState& state, std::span<const std::byte> message, std::span<std::byte, 32> dest) noexcept
+        {
+            Sha256Kernels::hmac(state,
+                                reinterpret_cast<const unsigned char*>(message.data()),
+                                message.size(),
+                                reinterpret_cast<unsigned char*>(dest.data()));
+        }
+    };
+
+
+    /**
+     * @brief HMAC-SHA256 with a fixed key.
+     *        The key schedule (the inner and outer padded key blocks) is absorbed once in the constructor; each
+     *        signature resumes from that state so the per-call cost is only the message itself.
+     * @tparam Backend `OpenSslHmacSha256` or `NativeHmacSha256`; both produce identical signatures
+     * @remarks `sign` does not modify the signer and may be called from any number of threads at once.
+     */
+    template <typename Backend>
+    class BasicHmacSha256Signer
+    {
+    public:
+        /// @brief Size of the binary signature
+        static constexpr std::size_t DigestSize = 32;
+
+
+        /// @brief Absorb the key
+        /// @param key The binary key (for example the decoded SAS or Cosmos key)
+        /// @throws std::invalid_argument if the key is empty
+        /// @throws std::runtime_error if the backend cannot provide HMAC-SHA256
+        explicit BasicHmacSha256Signer(std::span<const std::byte> key)
+            : keyState(Backend::absorbKey(checkedKey(key)))
+        {
+        }
+
+
+        /// @brief Absorb the key
+        /// @param key The binary key held in a string (as returned by `Base64Utils::decode`)
+        explicit BasicHmacSha256Signer(std::string_view key)
+            : BasicHmacSha256Signer(std::as_bytes(std::span(key)))
+        {
+        }
+
+
+        /// @brief Sign the message into the caller's buffer
+        /// @param message The bytes to sign
+        /// @param dest Receives the binary signature
+        /// @throws std::runtime_error if the backend fails
+        void sign(std::span<const std::byte> message, std::span<std::byte, DigestSize> dest) const
+        {
+            Backend::sign(keyState, message, dest);
+        }
+
+
+        /// @brief Sign the message
+        /// @param message The string to sign
+        /// @return Binary signature enclosed in string (same as `EncryptionUtils::HMAC`); you must base64 encode.
+        std::string sign(std::string_view message) const
+        {
+            std::string signature(DigestSize, 0);
+
+            sign(std::as_bytes(std::span(message)),
+                 std::span<std::byte, DigestSize>(reinterpret_cast<std::byte*>(signature.data()), DigestSize));
+            return signature;
+        }
+
+    private:
+        static std::span<const std::byte> checkedKey(std::span<const std::byte> key)
+        {
+            if (key.empty()) throw std::invalid_argument("HmacSha256Signer: key may not be empty");
+            return key;
+        }
+
+        typename Backend::KeyState keyState;
+    };
+
+
+    /// @brief HMAC-SHA256 signer using OpenSSL
+    using HmacSha256Signer = BasicHmacSha256Signer<OpenSslHmacSha256>;
+
+    /// @brief HMAC-SHA256 signer using the built-in SHA-256 (SHA extensions when available)
+    using NativeHmacSha256Signer = BasicHmacSha256Signer<NativeHmacSha256>;
+
+
+    /**
+     * @brief Incremental message digest over any number of buffers.
+     *        Feed the payload in pieces with `update` and take the result with `final`; the memory use is constant however
+     *        large the payload (for example the Content-MD5 of a blob uploaded block by block).
+     * @remarks One `EVP_MD_CTX` is kept for the life of the object. `final` re-initializes it so the object is ready for
+     *          the next payload and `reset` discards a partial payload. Use one object per stream; it is not thread-safe.
+     */
+    class Digest
+    {
+    public:
+        /// @brief Start an empty payload
+        /// @param digestType The algorithm; resolved through the process-wide `OpenSslAlgorithms` cache
+        /// @throws std::invalid_argument if no loaded provider implements the algorithm (for example MD4 without the legacy
+        /// provider)
+        /// @throws std::runtime_error if OpenSSL fails
+        explicit Digest(DigestType digestType)
+            : algorithm(OpenSslAlgorithms::digest(digestType))
+            , ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free)
+        {
+            if (algorithm == nullptr) throw std::invalid_argument("Digest: the algorithm is not available");
+            if (!ctx) throw std::runtime_error("Digest: failed to allocate the context");
+            reset();
+        }
+
+
+        /// @brief Number of bytes in the raw digest; 16 for MD5 and 32 for SHA-256
+        std::size_t size() const noexcept { return static_cast<std::size_t>(EVP_MD_get_size(algorithm)); }
+
+
+        /// @brief Discard the payload so far
+        /// @throws std::runtime_error if OpenSSL fails
+        void reset()
+        {
+            if (!EVP_DigestInit_ex2(ctx.get(), algorithm, NULL)) throw std::runtime_error("Digest: failed to initialize");
+        }
+
+
+        /// @brief Append the bytes to the payload
+        /// @throws std::runtime_error if OpenSSL fails
+        Digest& update(std::span<const std::byte> data)
+        {
+            if (!data.empty() && !EVP_DigestUpdate(ctx.get(), data.data(), data.size()))
+                throw std::runtime_error("Digest: failed to update");
+            return *this;
+        }
+
+
+        /// @brief Append the string to the payload
+        Digest& update(std::string_view data) { return update(std::as_bytes(std::span(data))); }
+
+
+        /// @brief Finish the payload and write the raw digest; the object starts a new payload
+        /// @param dest Must have room for `size()` bytes
+        /// @return Number of bytes written
+        /// @throws std::invalid_argument if the destination is too small
+        /// @throws std::runtime_error if OpenSSL fails
+        std::size_t final(std::span<std::byte> dest)
+        {
+            unsigned int written = 0;
+
+            if (dest.size() < size())
+                throw std::invalid_argument(
+                        std::format("Digest: destination requires {} bytes; only {} available", size(), dest.size()));
+            if (!EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(dest.data()), &written))
+                throw std::runtime_error("Digest: failed to finalize");
+
+            reset();
+            return written;
+        }
+
+
+        /// @brief Finish the payload; the object starts a new payload
+        /// @return Binary digest enclosed in string
+        std::string final()
+        {
+            std::string digestValue(size(), 0);
+
+            final(std::as_writable_bytes(std::span(digestValue)));
+            return digestValue;
+        }
+
+
+        /// @brief Finish the payload; the object starts a new payload
+        /// @param format The presentation of the digest
+        std::string final(DigestFormat format)
+        {
+            std::array<std::byte, EVP_MAX_MD_SIZE> digestValue;
+
+            return Digest::format(std::span(digestValue).first(final(digestValue)), format);
+        }
+
+
+        /// @brief Finish the payload; the object starts a new payload
+        /// @return The digest as a sequence of lowercase hex characters (as `EncryptionUtils::calcDigest`)
+        std::string finalHex() { return final(DigestFormat::Hex); }
+
+
+        /// @brief Finish the payload; the object starts a new payload
+        /// @return The digest base64 encoded; for example the value of the Content-MD5 header
+        std::string finalBase64() { return final(DigestFormat::Base64); }
+
+
+        /// @brief Present a binary digest
+        static std::string format(std::span<const std::byte> digestValue, DigestFormat format)
+        {
+            switch (format) {
+                case DigestFormat::Raw: return std::string(reinterpret_cast<const char*>(digestValue.data()), digestValue.size());
+                case DigestFormat::UpperHex: return HexUtils::encode(digestValue, true);
+                case DigestFormat::Base64: return Base64Utils::encode(digestValue);
+                default: return HexUtils::encode(digestValue);
+            }
+        }
+
+    private:
+        const EVP_MD*                                           algorithm;
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx;
+    };
+
+
     /**
      * @brief Encryption utility functions for ServiceBus, Cosmos, EventGrid, EventHub
      *        Implementation Note!
@@ -75,42 +442,70 @@ namespace siddiqsoft
     struct EncryptionUtils
     {
         /**
-         * @brief Calculate digest MD4, MD5
+         * @brief Calculate the digest
          *
-         * @param digestType "MD5" or "MD4"
+         * @param digestType The algorithm; resolved through the process-wide `OpenSslAlgorithms` cache
+         * @param source The source bytes to calculate the digest
+         * @param format The presentation of the digest; lowercase hex by default
+         * @return std::string returns a string containing the digest as a sequence of hex characters (or as selected by
+         * `format`); empty if the source is empty or the algorithm is not available
+         */
+        static std::string
+        calcDigest(DigestType digestType, std::span<const std::byte> source, DigestFormat format = DigestFormat::Hex)
+        {
+            return calcDigest(OpenSslAlgorithms::digest(digestType), source, format);
+        }
+
+
+        /**
+         * @brief Calculate the digest
+         *
+         * @param digestType The algorithm; resolved through the process-wide `OpenSslAlgorithms` cache
          * @param source The source string to calculate the digest
+         * @param format The presentation of the digest; lowercase hex by default
          * @return std::string returns a string containing the digest as a sequence of hex characters.
          */
-        static std::string calcDigest(const std::string& digestType, const std::string& source)
+        static std::string calcDigest(DigestType digestType, std::string_view source, DigestFormat format = DigestFormat::Hex)
         {
-            std::string result;
+            return calcDigest(digestType, std::as_bytes(std::span(source)), format);
+        }
 
-            if (!source.empty() && ((digestType.find("MD5") == 0) || (digestType.find("MD4") == 0))) {
-                if (const auto digestAlgorithm = EVP_get_digestbyname(digestType.c_str()); digestAlgorithm != NULL) {
-                    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
 
-                    if (EVP_DigestInit_ex2(ctx.get(), digestAlgorithm, NULL)) {
-                        if (EVP_DigestUpdate(ctx.get(), source.c_str(), source.length())) {
-                            unsigned char digestValue[EVP_MAX_MD_SIZE];
-                            unsigned int  digestValueLength = 0;
+        /**
+         * @brief Calculate digest MD4, MD5
+         *
+         * @param digestType "MD5" or "MD4"; other names starting with "MD5" or "MD4" (for example "MD5-SHA1") are fetched
+         * by name once and cached
+         * @param source The source bytes to calculate the digest
+         * @return std::string returns a string containing the digest as a sequence of hex characters; empty for any other
+         * name
+         * @throws std::runtime_error if no loaded provider implements the named digest
+         * @remarks Prefer the `DigestType` overload which does not parse the name on every call.
+         */
+        static std::string calcDigest(std::string_view digestType, std::span<const std::byte> source)
+        {
+            if (source.empty()) return {};
+            if (digestType == "MD5") return calcDigest(DigestType::MD5, source);
+            if (digestType == "MD4") return calcDigest(DigestType::MD4, source);
+            if (!(digestType.starts_with("MD5") || digestType.starts_with("MD4"))) return {};
 
-                            if (EVP_DigestFinal_ex(ctx.get(), digestValue, &digestValueLength)) {
-                                // encode and return..
-                                for (int i = 0; i < digestValueLength; i++) {
-                                    std::format_to(std::back_inserter(result), "{:02x}", digestValue[i]);
-                                }
+            if (const auto digestAlgorithm = OpenSslAlgorithms::digest(digestType); digestAlgorithm != nullptr)
+                return calcDigest(digestAlgorithm, source, DigestFormat::Hex);
 
-                                return result;
-                            }
-                        }
-                    }
-                }
-                else {
-                    throw std::runtime_error(std::format("Unknown or unsupported `{}` digest type.", digestType).c_str());
-                }
-            }
+            throw std::runtime_error(std::format("Unknown or unsupported `{}` digest type.", digestType).c_str());
+        }
 
-            return result;
+
+        /**
+         * @brief Calculate digest MD4, MD5
+         *
+         * @param digestType "MD5" or "MD4"; see the `std::span` overload
+         * @param source The source string to calculate the digest
+         * @return std::string returns a string containing the digest as a sequence of hex characters.
+         */
+        static std::string calcDigest(std::string_view digestType, std::string_view source)
+        {
+            return calcDigest(digestType, std::as_bytes(std::span(source)));
         }
 
 
@@ -119,15 +514,37 @@ namespace siddiqsoft
          *
          * @tparam T char or wchar_t
          * @param source Maybe std::string or std::wstring
+         * @param format The presentation of the digest; lowercase hex by default and `DigestFormat::Base64` for Content-MD5
          * @return  MD5 of the source argument empty if there is a failure
          */
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::string MD5(const std::basic_string<T>& source)
+        static std::string MD5(std::type_identity_t<std::basic_string_view<T>> source, DigestFormat format = DigestFormat::Hex)
+        {
+            // The MD5 works on the utf8 character set so wchar_t is transcoded first
+            if constexpr (std::is_same_v<T, char>)
+                return EncryptionUtils::calcDigest(DigestType::MD5, source, format);
+            else
+                return EncryptionUtils::calcDigest(DigestType::MD5, Utf8Utils::toUtf8(source), format);
+        }
+
+
+        /// @brief Create a MD5 hash; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::string MD5(const std::basic_string<T, Traits, Alloc>& source, DigestFormat format = DigestFormat::Hex)
         {
-            // Convert from wchar_t or we return as-is for the conversion. The MD5 works on the
-            // utf8 character set.
-            return EncryptionUtils::calcDigest("MD5", ConversionUtils::convert_to<T, char>(source));
+            return MD5<T>(std::basic_string_view<T>(source), format);
+        }
+
+
+        /// @brief Create a MD5 hash for the given bytes
+        /// @param source The bytes
+        /// @param format The presentation of the digest; lowercase hex by default
+        /// @return MD5 of the source; empty if there is a failure
+        static std::string MD5(std::span<const std::byte> source, DigestFormat format = DigestFormat::Hex)
+        {
+            return EncryptionUtils::calcDigest(DigestType::MD5, source, format);
         }
 
 
@@ -141,41 +558,149 @@ namespace siddiqsoft
          */
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::string HMAC(const std::basic_string<T>& message, const std::string& key)
+        static std::string HMAC(std::type_identity_t<std::basic_string_view<T>> message, std::string_view key)
+        {
+            if constexpr (std::is_same_v<T, char>) {
+                return HMAC(std::as_bytes(std::span(message)), std::as_bytes(std::span(key)));
+            }
+            else {
+                return HMAC<char>(Utf8Utils::toUtf8(message), key);
+            }
+        }
+
+
+        /// @brief Returns binary HMAC using SHA-256; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::string HMAC(const std::basic_string<T, Traits, Alloc>& message, std::string_view key)
+        {
+            return HMAC<T>(std::basic_string_view<T>(message), key);
+        }
+
+
+        /**
+         * @brief Returns binary HMAC using SHA-256 of the given bytes.
+         * @param message The message to generate the HMAC
+         * @param key The key for the given digest generation
+         * @return Binary enclosed in string; you must base64 encode.
+         */
+        static std::string HMAC(std::span<const std::byte> message, std::span<const std::byte> key)
         {
             std::string result;
 
-            if constexpr (std::is_same_v<T, char>) {
-                if (!message.empty() && !key.empty()) {
-                    if (const auto digestAlgorithm = EVP_get_digestbyname("SHA256"); digestAlgorithm != NULL) {
-                        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
-
-
-                        unsigned char digestValue[EVP_MAX_MD_SIZE];
-                        unsigned int  digestValueLength = 0;
-
-                        if (auto rc = ::HMAC(digestAlgorithm,
-                                             key.c_str(),
-                                             key.length(),
-                                             reinterpret_cast<const unsigned char*>(message.c_str()),
-                                             message.length(),
-                                             digestValue,
-                                             &digestValueLength);
-                            rc != NULL)
-                        {
-                            return std::string(reinterpret_cast<char*>(digestValue), digestValueLength);
-                        }
-                    }
-                    else {
-                        throw std::runtime_error(std::format("Unknown or unsupported  digest type.").c_str());
+            if (!message.empty() && !key.empty()) {
+                // The one-shot ::HMAC resolves the algorithms by name on every call; duplicate the cached keyless
+                // context (digest already set) and only add the key
+                if (const auto keyless = OpenSslAlgorithms::hmacSha256(); keyless != nullptr) {
+                    std::unique_ptr<EVP_MAC_CTX, decltype(&EVP_MAC_CTX_free)> ctx(EVP_MAC_CTX_dup(keyless), &EVP_MAC_CTX_free);
+
+                    std::string digestValue(HmacSha256Signer::DigestSize, 0);
+                    std::size_t digestValueLength = 0;
+
+                    if (ctx && EVP_MAC_init(ctx.get(), reinterpret_cast<const unsigned char*>(key.data()), key.size(), NULL) &&
+                        EVP_MAC_update(ctx.get(), reinterpret_cast<const unsigned char*>(message.data()), message.size()) &&
+                        EVP_MAC_final(ctx.get(),
+                                      reinterpret_cast<unsigned char*>(digestValue.data()),
+                                      &digestValueLength,
+                                      digestValue.size()))
+                    {
+                        return digestValue;
                     }
                 }
+                else {
+                    throw std::runtime_error(std::format("Unknown or unsupported  digest type.").c_str());
+                }
+            }
+
+            return result;
+        }
+
+
+        /// @brief A binary HMAC-SHA256 signature as written by `HMACBatch`
+        using HmacDigest = std::array<std::byte, HmacSha256Signer::DigestSize>;
+
+
+        /**
+         * @brief Returns binary HMAC using SHA-256 of many messages signed with the same key.
+         *        The messages are hashed side by side by the multi-buffer `Sha256Kernels` (eight at a time with AVX2,
+         *        sixteen with AVX-512) on the calling thread. Without AVX2 (or the SHA extensions) each message is
+         *        signed by OpenSSL.
+         * @param key Binary key
+         * @param messages The messages to sign; unlike `HMAC` an empty message is signed
+         * @param digests Receives the signature of each message in order; must have room for `messages.size()`
+         * @return The leading `messages.size()` digests
+         * @throws std::invalid_argument if the key is empty or `digests` is too small
+         */
+        static std::span<HmacDigest>
+        HMACBatch(std::string_view key, std::span<const std::string_view> messages, std::span<HmacDigest> digests)
+        {
+            if (key.empty()) throw std::invalid_argument("HMACBatch: key may not be empty");
+            if (digests.size() < messages.size())
+                throw std::invalid_argument(
+                        std::format("HMACBatch: {} digests required; only {} available", messages.size(), digests.size()));
+
+            if (Sha256Kernels::bestKernel() == Sha256Kernels::Kernel::Scalar) {
+                HmacSha256Signer signer(key);
+
+                for (std::size_t i = 0; i < messages.size(); i++) {
+                    signer.sign(std::as_bytes(std::span(messages[i])), digests[i]);
+                }
             }
             else {
-                return HMAC(ConversionUtils::convert_to<T, char>(message), key);
+                const Sha256Kernels::HmacKey schedule = Sha256Kernels::hmacKey(std::as_bytes(std::span(key)));
+                Sha256Kernels::hmacBatch(std::span(&schedule, 1), messages, digests);
             }
 
-            return result;
+            return digests.first(messages.size());
+        }
+
+
+        /**
+         * @brief Returns binary HMAC using SHA-256 of many messages each signed with its own key.
+         * @param keys Binary key for each message
+         * @param messages The messages to sign; unlike `HMAC` an empty message is signed
+         * @param digests Receives the signature of each message in order; must have room for `messages.size()`
+         * @return The leading `messages.size()` digests
+         * @throws std::invalid_argument if any key is empty, the number of keys differs from the number of messages or
+         *         `digests` is too small
+         */
+        static std::span<HmacDigest> HMACBatch(std::span<const std::string_view> keys,
+                                               std::span<const std::string_view> messages,
+                                               std::span<HmacDigest>             digests)
+        {
+            if (keys.size() != messages.size())
+                throw std::invalid_argument(
+                        std::format("HMACBatch: {} keys given for {} messages", keys.size(), messages.size()));
+            if (digests.size() < messages.size())
+                throw std::invalid_argument(
+                        std::format("HMACBatch: {} digests required; only {} available", messages.size(), digests.size()));
+            if (std::ranges::any_of(keys, [](auto key) { return key.empty(); }))
+                throw std::invalid_argument("HMACBatch: key may not be empty");
+
+            if (Sha256Kernels::bestKernel() == Sha256Kernels::Kernel::Scalar) {
+                for (std::size_t i = 0; i < messages.size(); i++) {
+                    HmacSha256Signer(keys[i]).sign(std::as_bytes(std::span(messages[i])), digests[i]);
+                }
+            }
+            else {
+                std::array<Sha256Kernels::HmacKey, Sha256Kernels::BatchSize> schedules;
+
+                for (std::size_t first = 0; first < messages.size(); first += Sha256Kernels::BatchSize) {
+                    const auto count = std::min(Sha256Kernels::BatchSize, messages.size() - first);
+
+                    // Runs of the same key share the schedule
+                    for (std::size_t i = 0; i < count; i++) {
+                        schedules[i] = ((i > 0) && (keys[first + i] == keys[first + i - 1]))
+                                               ? schedules[i - 1]
+                                               : Sha256Kernels::hmacKey(std::as_bytes(std::span(keys[first + i])));
+                    }
+                    Sha256Kernels::hmacBatch(std::span(schedules).first(count),
+                                             messages.subspan(first, count),
+                                             digests.subspan(first, count));
+                }
+            }
+
+            return digests.first(messages.size());
         }
 
 
@@ -186,26 +711,38 @@ namespace siddiqsoft
         /// @return HMAC256 encoded JWT token
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T>
-        JWTHMAC256(const std::string& key, const std::basic_string<T>& header, const std::basic_string<T>& payload)
+        static std::basic_string<T> JWTHMAC256(std::string_view                                key,
+                                               std::type_identity_t<std::basic_string_view<T>> header,
+                                               std::type_identity_t<std::basic_string_view<T>> payload)
         {
             if constexpr (std::is_same_v<T, char>) {
-                auto s1        = Base64Utils::urlEscape<char>(Base64Utils::encode<char>(header));
-                auto s2        = Base64Utils::urlEscape<char>(Base64Utils::encode<char>(payload));
+                // JWT uses unpadded base64url (RFC 7515 §2) which the encoder emits directly
+                auto s1        = Base64Utils::encode<char>(header, Base64Alphabet::UrlSafe, false);
+                auto s2        = Base64Utils::encode<char>(payload, Base64Alphabet::UrlSafe, false);
                 auto a3        = std::format("{}.{}", s1, s2);
                 auto a4        = HMAC<char>(a3, key);
-                auto signature = Base64Utils::urlEscape<char>(Base64Utils::encode<char>(a4));
+                auto signature = Base64Utils::encode<char>(a4, Base64Alphabet::UrlSafe, false);
 
                 return std::format("{}.{}.{}", s1, s2, signature);
             }
             else {
                 // Delegate to the narrow version; conversion at the edge
-                return ConversionUtils::convert_to<char, T>(JWTHMAC256<char>(
-                        key, ConversionUtils::convert_to<T, char>(header), ConversionUtils::convert_to<T, char>(payload)));
+                return Utf8Utils::toWide(JWTHMAC256<char>(key, Utf8Utils::toUtf8(header), Utf8Utils::toUtf8(payload)));
             }
         }
 
 
+        /// @brief Create a JsonWebToken authorization with HMAC 256; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> JWTHMAC256(std::string_view                           key,
+                                               const std::basic_string<T, Traits, Alloc>& header,
+                                               const std::basic_string<T, Traits, Alloc>& payload)
+        {
+            return JWTHMAC256<T>(key, std::basic_string_view<T>(header), std::basic_string_view<T>(payload));
+        }
+
+
         /// @brief Create a Shared Access Signature for Azure storage
         /// https://docs.microsoft.com/en-us/rest/api/eventhub/generate-sas-token
         /// @param key The key is "binary" in std::string
@@ -215,10 +752,10 @@ namespace siddiqsoft
         /// @return SAS token
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> SASToken(const std::string&          key,
-                                             const std::basic_string<T>& url,
-                                             const std::basic_string<T>& keyName,
-                                             const std::chrono::seconds& timeout)
+        static std::basic_string<T> SASToken(std::string_view                                key,
+                                             std::type_identity_t<std::basic_string_view<T>> url,
+                                             std::type_identity_t<std::basic_string_view<T>> keyName,
+                                             const std::chrono::seconds&                     timeout)
         {
             time_t epoch {};
 
@@ -233,6 +770,18 @@ namespace siddiqsoft
         }
 
 
+        /// @brief Create a Shared Access Signature for Azure storage; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> SASToken(std::string_view                           key,
+                                             const std::basic_string<T, Traits, Alloc>& url,
+                                             const std::basic_string<T, Traits, Alloc>& keyName,
+                                             const std::chrono::seconds&                timeout)
+        {
+            return SASToken<T>(key, std::basic_string_view<T>(url), std::basic_string_view<T>(keyName), timeout);
+        }
+
+
         /// @brief Create a Shared Access Signature for Azure storage
         /// https://docs.microsoft.com/en-us/rest/api/eventhub/generate-sas-token
         /// @param key The key to sign the url with time
@@ -242,10 +791,10 @@ namespace siddiqsoft
         /// @return SAS token
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> SASToken(const std::string&          key,
-                                             const std::basic_string<T>& url,
-                                             const std::basic_string<T>& keyName,
-                                             const std::basic_string<T>& expiry)
+        static std::basic_string<T> SASToken(std::string_view                                key,
+                                             std::type_identity_t<std::basic_string_view<T>> url,
+                                             std::type_identity_t<std::basic_string_view<T>> keyName,
+                                             std::type_identity_t<std::basic_string_view<T>> expiry)
         {
             if (url.empty()) throw std::invalid_argument("SASToken: url may not be empty");
             if (keyName.empty()) throw std::invalid_argument("SASToken: keyName may not be empty");
@@ -262,14 +811,116 @@ namespace siddiqsoft
             }
             else {
                 // Delegate to the narrow version and convert at the edges.
-                return ConversionUtils::convert_to<char, T>(SASToken<char>(key,
-                                                                           ConversionUtils::convert_to<T, char>(url),
-                                                                           ConversionUtils::convert_to<T, char>(keyName),
-                                                                           ConversionUtils::convert_to<T, char>(expiry)));
+                return Utf8Utils::toWide(SASToken<char>(
+                        key, Utf8Utils::toUtf8(url), Utf8Utils::toUtf8(keyName), Utf8Utils::toUtf8(expiry)));
             }
         }
 
 
+        /// @brief Create a Shared Access Signature for Azure storage; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> SASToken(std::string_view                           key,
+                                             const std::basic_string<T, Traits, Alloc>& url,
+                                             const std::basic_string<T, Traits, Alloc>& keyName,
+                                             const std::basic_string<T, Traits, Alloc>& expiry)
+        {
+            return SASToken<T>(
+                    key, std::basic_string_view<T>(url), std::basic_string_view<T>(keyName), std::basic_string_view<T>(expiry));
+        }
+
+
+        /// @brief Characters that hold any Cosmos authorization token: the fixed prefix and the escaped base64 signature where
+        /// every character may need escaping
+        static constexpr std::size_t CosmosTokenSize = 34 + (Base64Kernels::encodedSize(HmacSha256Signer::DigestSize) * 3);
+
+
+        /**
+         * @brief Write the Cosmos authorization token into a caller-provided buffer.
+         *        The string-to-sign is built on the stack (unless the resource link is unusually long) and the signature,
+         *        its base64 and the escaped token are written in place so there are no heap allocations with the
+         *        `NativeHmacSha256` backend.
+         * @param signer Signer holding the binary key decoded from the connection string
+         * @param verb GET, POST, PUT, DELETE
+         * @param type One of the following: dbs, docs, colls, attachments or empty
+         * @param resourceLink The resource link sub-uri
+         * @param date Date in RFC7231 as string
+         * @param dest Receives the token
+         * @return View of the token within `dest`; identical to the string returned by `CosmosToken<char>`
+         * @throws std::invalid_argument if the verb or date is empty
+         */
+        template <typename Backend>
+        static std::string_view CosmosToken(const BasicHmacSha256Signer<Backend>& signer,
+                                            std::string_view                      verb,
+                                            std::string_view                      type,
+                                            std::string_view                      resourceLink,
+                                            std::string_view                      date,
+                                            std::span<char, CosmosTokenSize>      dest)
+        {
+            if (date.empty()) throw std::invalid_argument("CosmosToken: date may not be empty");
+            if (verb.empty()) throw std::invalid_argument("CosmosToken: verb may not be empty");
+
+            // The formula is expressed as per
+            // https://docs.microsoft.com/en-us/rest/api/documentdb/access-control-on-documentdb-resources?redirectedfrom=MSDN
+            // The verb, type and date are lowercased; they are ASCII.
+            const auto                 length = verb.length() + type.length() + resourceLink.length() + date.length() + 5;
+            std::array<char, 512>      stackBuffer;
+            std::string                heapBuffer;
+            char*                      strToHash = stackBuffer.data();
+            constexpr std::string_view prefix {"type%3dmaster%26ver%3d1.0%26sig%3d"};
+
+            if (length > stackBuffer.size()) {
+                heapBuffer.resize(length);
+                strToHash = heapBuffer.data();
+            }
+
+            char* out = lowerCaseAscii(verb, strToHash);
+            *out++    = '\n';
+            out       = lowerCaseAscii(type, out);
+            *out++    = '\n';
+            out       = std::ranges::copy(resourceLink, out).out;
+            *out++    = '\n';
+            out       = lowerCaseAscii(date, out);
+            *out++    = '\n';
+            *out++    = '\n';
+
+            // Sign using SHA256 using the master key and base64 encode; the escapes are lowercase
+            std::array<std::byte, HmacSha256Signer::DigestSize>                       signature;
+            std::array<char, Base64Kernels::encodedSize(HmacSha256Signer::DigestSize)> encoded;
+
+            signer.sign(std::as_bytes(std::span(strToHash, length)), signature);
+            Base64Kernels::encode(reinterpret_cast<const unsigned char*>(signature.data()),
+                                  signature.size(),
+                                  encoded.data(),
+                                  Base64Alphabet::Standard,
+                                  true);
+
+            std::ranges::copy(prefix, dest.data());
+            return {dest.data(),
+                    UrlUtils::escape<UrlUtils::Component<true>>(encoded.data(), encoded.size(), dest.data() + prefix.length())};
+        }
+
+
+        /// @brief Write the Cosmos authorization token into a caller-provided buffer using `NativeHmacSha256Signer`
+        /// @param key Binary. The key must be decoded from the base64 value in the connection string from the Azure portal
+        /// @param dest Receives the token
+        /// @return View of the token within `dest`
+        /// @throws std::invalid_argument if the key, verb or date is empty
+        static std::string_view CosmosToken(std::string_view                 key,
+                                            std::string_view                 verb,
+                                            std::string_view                 type,
+                                            std::string_view                 resourceLink,
+                                            std::string_view                 date,
+                                            std::span<char, CosmosTokenSize> dest)
+        {
+            if (key.empty()) throw std::invalid_argument("CosmosToken: key may not be empty");
+            if (date.empty()) throw std::invalid_argument("CosmosToken: date may not be empty");
+            if (verb.empty()) throw std::invalid_argument("CosmosToken: verb may not be empty");
+
+            return CosmosToken(NativeHmacSha256Signer {key}, verb, type, resourceLink, date, dest);
+        }
+
+
         /// @brief Create the Cosmos Authorization Token using the Key for this connection.
         /// @param key Binary. The key must be decoded from the base64 value in the connection string from the Azure portal
         /// @param verb GET, POST, PUT, DELETE
@@ -279,50 +930,78 @@ namespace siddiqsoft
         /// @return Cosmos Authorization signature as std::string. It is base64 encoded and urlsafe
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> CosmosToken(const std::string&          key,
-                                                const std::basic_string<T>& verb,
-                                                const std::basic_string<T>& type,
-                                                const std::basic_string<T>& resourceLink,
-                                                const std::basic_string<T>& date)
+        static std::basic_string<T> CosmosToken(std::string_view                                key,
+                                                std::type_identity_t<std::basic_string_view<T>> verb,
+                                                std::type_identity_t<std::basic_string_view<T>> type,
+                                                std::type_identity_t<std::basic_string_view<T>> resourceLink,
+                                                std::type_identity_t<std::basic_string_view<T>> date)
         {
             if (key.empty()) throw std::invalid_argument("CosmosToken: key may not be empty");
             if (date.empty()) throw std::invalid_argument("CosmosToken: date may not be empty");
             if (verb.empty()) throw std::invalid_argument("CosmosToken: verb may not be empty");
 
             if constexpr (std::is_same_v<T, char>) {
-                // The formula is expressed as per
-                // https://docs.microsoft.com/en-us/rest/api/documentdb/access-control-on-documentdb-resources?redirectedfrom=MSDN
-                std::string strToHash {};
-
-                std::ranges::transform(verb, std::back_inserter(strToHash), [](auto& ch) { return std::tolower(ch); });
-                std::format_to(std::back_inserter(strToHash), "\n");
-                std::ranges::transform(type, std::back_inserter(strToHash), [](auto& ch) { return std::tolower(ch); });
-                std::format_to(std::back_inserter(strToHash), "\n{}\n", resourceLink);
-                std::ranges::transform(date, std::back_inserter(strToHash), [](auto& ch) { return std::tolower(ch); });
-                std::format_to(std::back_inserter(strToHash), "\n\n");
-
-                if (!strToHash.empty()) {
-                    // Sign using SHA256 using the master key and base64 encode. force lowercase
-                    if (auto hmacBase64UrlEscaped = UrlUtils::encode<char>(
-                                Base64Utils::encode<char>(EncryptionUtils::HMAC<char>(strToHash, key)), true);
-                        !hmacBase64UrlEscaped.empty())
-                    {
-                        return std::format("type%3dmaster%26ver%3d1.0%26sig%3d{}", hmacBase64UrlEscaped);
-                    }
-                }
+                std::array<char, CosmosTokenSize> token;
+
+                return std::string(CosmosToken(key, verb, type, resourceLink, date, token));
             }
             else {
                 // Delegate to the narrow version, conversion at the edges.
-                return ConversionUtils::convert_to<char, T>(CosmosToken<char>(key,
-                                                                              ConversionUtils::convert_to<T, char>(verb),
-                                                                              ConversionUtils::convert_to<T, char>(type),
-                                                                              ConversionUtils::convert_to<T, char>(resourceLink),
-                                                                              ConversionUtils::convert_to<T, char>(date)));
+                return Utf8Utils::toWide(CosmosToken<char>(key,
+                                                           Utf8Utils::toUtf8(verb),
+                                                           Utf8Utils::toUtf8(type),
+                                                           Utf8Utils::toUtf8(resourceLink),
+                                                           Utf8Utils::toUtf8(date)));
+            }
+        }
+
+
+        /// @brief Create the Cosmos Authorization Token; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> CosmosToken(std::string_view                           key,
+                                                const std::basic_string<T, Traits, Alloc>& verb,
+                                                const std::basic_string<T, Traits, Alloc>& type,
+                                                const std::basic_string<T, Traits, Alloc>& resourceLink,
+                                                const std::basic_string<T, Traits, Alloc>& date)
+        {
+            return CosmosToken<T>(key,
+                                  std::basic_string_view<T>(verb),
+                                  std::basic_string_view<T>(type),
+                                  std::basic_string_view<T>(resourceLink),
+                                  std::basic_string_view<T>(date));
+        }
+
+    private:
+        /// @brief The digest of the bytes with the fetched algorithm; empty if the source is empty, the algorithm is
+        /// nullptr or OpenSSL fails
+        static std::string calcDigest(const EVP_MD* digestAlgorithm, std::span<const std::byte> source, DigestFormat format)
+        {
+            if (!source.empty() && (digestAlgorithm != nullptr)) {
+                std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+
+                if (ctx && EVP_DigestInit_ex2(ctx.get(), digestAlgorithm, NULL) &&
+                    EVP_DigestUpdate(ctx.get(), source.data(), source.size()))
+                {
+                    unsigned char digestValue[EVP_MAX_MD_SIZE];
+                    unsigned int  digestValueLength = 0;
+
+                    if (EVP_DigestFinal_ex(ctx.get(), digestValue, &digestValueLength)) {
+                        return Digest::format(std::as_bytes(std::span(digestValue, digestValueLength)), format);
+                    }
+                }
             }
 
-            // Fall-through failure
             return {};
         }
+
+
+        /// @brief Copy with ASCII letters lowercased
+        static char* lowerCaseAscii(std::string_view source, char* dest) noexcept
+        {
+            for (auto ch : source) *dest++ = ((ch >= 'A') && (ch <= 'Z')) ? static_cast<char>(ch + ('a' - 'A')) : ch;
+            return dest;
+        }
     };
 } // namespace siddiqsoft
 #else
@@ -41,3 +41,7 @@
 #elif defined(__linux__) || defined(__APPLE__)
 #   include "encryption-utils-unix.hpp"
 #endif
+
+// The token caches are platform neutral
+#include "sas-token-cache.hpp"
+#include "cosmos-token-cache.hpp"
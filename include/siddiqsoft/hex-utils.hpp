@@ -0,0 +1,382 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef HEX_UTILS_HPP
+#define HEX_UTILS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "cpu-features.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Hex (base16) encoding and decoding.
+    ///        Table driven with SSE4.1 and AVX2 kernels selected at runtime based on `CpuFeatures`; every kernel produces
+    ///        output identical to the scalar kernel. Decoding accepts either case.
+    struct HexUtils
+    {
+        /// @brief The available kernel implementations
+        enum class Kernel
+        {
+            Scalar,
+            SSE41,
+            AVX2
+        };
+
+
+        /// @brief Marker for "no error" in `DecodeResult::errorOffset`
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+
+        /// @brief Outcome of a decode operation
+        struct DecodeResult
+        {
+            /// @brief Number of bytes written to the destination
+            std::size_t written {0};
+            /// @brief Offset of the first character in the source that could not be decoded; `npos` on success
+            std::size_t errorOffset {npos};
+
+            constexpr explicit operator bool() const noexcept { return errorOffset == npos; }
+        };
+
+
+        alignas(16) static constexpr std::array<char, 16> LowerDigits {
+                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+        alignas(16) static constexpr std::array<char, 16> UpperDigits {
+                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+        /// @brief The value of each hex digit; 0xff for any other character
+        static constexpr std::array<std::uint8_t, 256> DigitValue = [] {
+            std::array<std::uint8_t, 256> values {};
+
+            values.fill(0xff);
+            for (std::uint8_t i = 0; i < 16; i++) {
+                values[static_cast<unsigned char>(LowerDigits[i])] = i;
+                values[static_cast<unsigned char>(UpperDigits[i])] = i;
+            }
+            return values;
+        }();
+
+
+        static bool isSupported(Kernel kernel) noexcept
+        {
+            const auto& cpu = CpuFeatures::current();
+
+            switch (kernel) {
+                case Kernel::Scalar: return true;
+#if defined(SIDDIQSOFT_X86_64)
+                case Kernel::SSE41: return cpu.sse41;
+                case Kernel::AVX2: return cpu.avx2;
+#endif
+                default: return false;
+            }
+        }
+
+
+        /// @brief The fastest kernel supported by this CPU; determined once per process
+        static Kernel bestKernel() noexcept
+        {
+            static const Kernel kernel = [] {
+                if (isSupported(Kernel::AVX2)) return Kernel::AVX2;
+                if (isSupported(Kernel::SSE41)) return Kernel::SSE41;
+                return Kernel::Scalar;
+            }();
+
+            return kernel;
+        }
+
+
+        /// @brief Encode `n` bytes from `src` into `dst`
+        /// @param dst Must have room for `2 * n` characters
+        /// @param upperCase Emit A-F instead of a-f
+        /// @param kernel The kernel must be supported by this CPU (see `isSupported`)
+        /// @return Number of characters written
+        static std::size_t
+        encode(const unsigned char* src, std::size_t n, char* dst, bool upperCase = false, Kernel kernel = bestKernel()) noexcept
+        {
+            const auto& digits   = upperCase ? UpperDigits : LowerDigits;
+            std::size_t consumed = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            switch (kernel) {
+                case Kernel::AVX2: consumed = encodeBlocksAVX2(src, n, dst, digits.data()); break;
+                case Kernel::SSE41: consumed = encodeBlocksSSE41(src, n, dst, digits.data()); break;
+                default: break;
+            }
+#endif
+
+            for (std::size_t i = consumed; i < n; i++) {
+                dst[i * 2]       = digits[src[i] >> 4];
+                dst[(i * 2) + 1] = digits[src[i] & 0x0f];
+            }
+            return n * 2;
+        }
+
+
+        /// @brief Decode `n` characters from `src` into `dst`
+        /// @param dst Must have room for `n / 2` bytes
+        /// @param kernel The kernel must be supported by this CPU (see `isSupported`)
+        /// @return The number of bytes written and, on failure, the offset of the offending character. An odd length fails
+        /// at the last character.
+        static DecodeResult decode(const char* src, std::size_t n, unsigned char* dst, Kernel kernel = bestKernel()) noexcept
+        {
+            std::size_t consumed = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            // The vector kernels stop at the block holding an invalid character; the scalar loop locates it
+            switch (kernel) {
+                case Kernel::AVX2: consumed = decodeBlocksAVX2(src, n, dst); break;
+                case Kernel::SSE41: consumed = decodeBlocksSSE41(src, n, dst); break;
+                default: break;
+            }
+#endif
+
+            for (std::size_t i = consumed; (i + 1) < n; i += 2) {
+                const auto hi = DigitValue[static_cast<unsigned char>(src[i])];
+                const auto lo = DigitValue[static_cast<unsigned char>(src[i + 1])];
+
+                if ((hi | lo) == 0xff) return {i / 2, (hi == 0xff) ? i : i + 1};
+                dst[i / 2] = static_cast<unsigned char>((hi << 4) | lo);
+            }
+
+            if ((n % 2) != 0) return {n / 2, n - 1};
+            return {n / 2, npos};
+        }
+
+
+        /// @brief Hex encode the bytes
+        /// @param source The bytes to encode
+        /// @param upperCase Emit A-F instead of a-f
+        static std::string encode(std::span<const std::byte> source, bool upperCase = false)
+        {
+            std::string dest(source.size() * 2, 0);
+
+            encode(reinterpret_cast<const unsigned char*>(source.data()), source.size(), dest.data(), upperCase);
+            return dest;
+        }
+
+
+        /// @brief Hex encode the bytes held in the string
+        static std::string encode(std::string_view source, bool upperCase = false)
+        {
+            return encode(std::as_bytes(std::span(source)), upperCase);
+        }
+
+
+        /// @brief Hex encode into a caller-provided buffer
+        /// @param dest Must have room for `2 * source.size()` characters
+        /// @return Number of characters written
+        /// @throws std::invalid_argument if the destination is too small
+        static std::size_t encodeInto(std::span<const std::byte> source, std::span<char> dest, bool upperCase = false)
+        {
+            if (dest.size() < (source.size() * 2))
+                throw std::invalid_argument(
+                        std::format("Destination requires {} characters; only {} available", source.size() * 2, dest.size()));
+
+            return encode(reinterpret_cast<const unsigned char*>(source.data()), source.size(), dest.data(), upperCase);
+        }
+
+
+        /// @brief Decode the hex string
+        /// @return The bytes enclosed in string; empty if the source is not valid hex (including an odd length)
+        static std::string decode(std::string_view source)
+        {
+            std::string dest(source.length() / 2, 0);
+
+            if (!decode(source.data(), source.length(), reinterpret_cast<unsigned char*>(dest.data()))) return {};
+            return dest;
+        }
+
+
+        /// @brief Decode into a caller-provided buffer
+        /// @param dest Must have room for `source.length() / 2` bytes
+        /// @return The number of bytes written and, on failure, the offset of the offending character
+        /// @throws std::invalid_argument if the destination is too small
+        static DecodeResult decodeInto(std::string_view source, std::span<std::byte> dest)
+        {
+            if (dest.size() < (source.length() / 2))
+                throw std::invalid_argument(
+                        std::format("Destination requires {} bytes; only {} available", source.length() / 2, dest.size()));
+
+            return decode(source.data(), source.length(), reinterpret_cast<unsigned char*>(dest.data()));
+        }
+
+    private:
+#if defined(SIDDIQSOFT_X86_64)
+        // Encoding splits each byte into nibbles and looks them up with a byte shuffle; decoding classifies each character
+        // as a digit or a letter (folded to lowercase) and joins the pairs with a multiply-add.
+        // Each returns the number of input bytes (encode) or characters (decode) consumed.
+
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t encodeBlocksSSE41(const unsigned char* src, std::size_t n, char* dst, const char* digits) noexcept
+        {
+            const __m128i table    = _mm_load_si128(reinterpret_cast<const __m128i*>(digits));
+            const __m128i mask     = _mm_set1_epi8(0x0f);
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 16; consumed += 16) {
+                const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed));
+                const __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+                const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(in, mask));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (consumed * 2)), _mm_unpacklo_epi8(hi, lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (consumed * 2) + 16), _mm_unpackhi_epi8(hi, lo));
+            }
+
+            return consumed;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t encodeBlocksAVX2(const unsigned char* src, std::size_t n, char* dst, const char* digits) noexcept
+        {
+            const __m256i table    = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(digits)));
+            const __m256i mask     = _mm256_set1_epi8(0x0f);
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 32; consumed += 32) {
+                const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + consumed));
+                const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+                const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(in, mask));
+                // The unpacks work within each 128-bit lane; the permutes restore the byte order
+                const __m256i first  = _mm256_unpacklo_epi8(hi, lo);
+                const __m256i second = _mm256_unpackhi_epi8(hi, lo);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (consumed * 2)),
+                                    _mm256_permute2x128_si256(first, second, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (consumed * 2) + 32),
+                                    _mm256_permute2x128_si256(first, second, 0x31));
+            }
+
+            return consumed;
+        }
+
+
+        /// @brief The digit values of 16 characters
+        /// @param valid Set to false if any character is not a hex digit
+        SIDDIQSOFT_TARGET("sse4.1")
+        static __m128i digitValuesSSE41(__m128i in, bool& valid) noexcept
+        {
+            const __m128i lower   = _mm_or_si128(in, _mm_set1_epi8(0x20));
+            const __m128i isDigit =
+                    _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8('9' + 1)));
+            const __m128i isAlpha =
+                    _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+            valid = _mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) == 0xffff;
+            return _mm_blendv_epi8(_mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)), _mm_sub_epi8(in, _mm_set1_epi8('0')), isDigit);
+        }
+
+
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t decodeBlocksSSE41(const char* src, std::size_t n, unsigned char* dst) noexcept
+        {
+            // Each 16-bit lane holds a (high, low) digit pair; the weights give high * 16 + low
+            const __m128i weights  = _mm_set1_epi16(0x0110);
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 32; consumed += 32) {
+                bool          validFirst = false, validSecond = false;
+                const __m128i first =
+                        digitValuesSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed)), validFirst);
+                const __m128i second =
+                        digitValuesSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + consumed + 16)), validSecond);
+
+                if (!(validFirst && validSecond)) break;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (consumed / 2)),
+                                 _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights)));
+            }
+
+            return consumed;
+        }
+
+
+        /// @brief The digit values of 32 characters
+        /// @param valid Set to false if any character is not a hex digit
+        SIDDIQSOFT_TARGET("avx2")
+        static __m256i digitValuesAVX2(__m256i in, bool& valid) noexcept
+        {
+            const __m256i lower   = _mm256_or_si256(in, _mm256_set1_epi8(0x20));
+            const __m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)),
+                                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+            const __m256i isAlpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+            valid = _mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) == -1;
+            return _mm256_blendv_epi8(
+                    _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)), _mm256_sub_epi8(in, _mm256_set1_epi8('0')), isDigit);
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t decodeBlocksAVX2(const char* src, std::size_t n, unsigned char* dst) noexcept
+        {
+            const __m256i weights  = _mm256_set1_epi16(0x0110);
+            std::size_t   consumed = 0;
+
+            for (; (n - consumed) >= 64; consumed += 64) {
+                bool          validFirst = false, validSecond = false;
+                const __m256i first =
+                        digitValuesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + consumed)), validFirst);
+                const __m256i second =
+                        digitValuesAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + consumed + 32)), validSecond);
+
+                if (!(validFirst && validSecond)) break;
+                // The pack interleaves the 128-bit lanes; the permute puts the quadwords back in order
+                const __m256i packed =
+                        _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (consumed / 2)), _mm256_permute4x64_epi64(packed, 0xd8));
+            }
+
+            return consumed;
+        }
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !HEX_UTILS_HPP
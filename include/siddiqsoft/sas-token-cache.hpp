@@ -0,0 +1,254 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef SAS_TOKEN_CACHE_HPP
+#define SAS_TOKEN_CACHE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "encryption-utils.hpp"
+#include "shared-snapshot.hpp"
+#include "siddiqsoft/RunOnEnd.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /**
+     * @brief Cache of Shared Access Signatures keyed by (url, keyName).
+     *        A SAS token is valid for its whole lifetime so it is generated once and shared until it is within the
+     *        refresh skew of its expiry; exactly one caller then regenerates it while the others keep using the current
+     *        token.
+     * @remarks Reads take no lock: each shard publishes an immutable map which is replaced (copy-on-write) only when an
+     *          entity is first seen, and each entry publishes an immutable token. Tokens are handed out as
+     *          `std::shared_ptr<const Token>` so a caller may hold one across a refresh.
+     *          The key is only used when a token is (re)generated; call `clear` when it is rotated.
+     */
+    class SasTokenCache
+    {
+    public:
+        using Clock = std::chrono::system_clock;
+
+        /// @brief An issued token
+        struct Token
+        {
+            /// @brief The `SharedAccessSignature ...` authorization value
+            std::string value;
+            /// @brief When the token expires (the `se` field)
+            Clock::time_point expiry;
+        };
+
+
+        /// @brief Create an empty cache
+        /// @param tokenLifetime How long each generated token is valid
+        /// @param refreshSkew Regenerate once a token is this close to its expiry; must be less than the lifetime
+        explicit SasTokenCache(std::chrono::seconds tokenLifetime = std::chrono::hours(1),
+                               std::chrono::seconds refreshSkew   = std::chrono::minutes(5)) noexcept
+            : lifetime(tokenLifetime)
+            , skew(refreshSkew)
+        {
+        }
+
+
+        /// @brief The token for the entity; generated on first use and regenerated when within the skew of expiry
+        /// @param key The binary signing key for the key name
+        /// @param url The entity url
+        /// @param keyName The key (policy) name
+        /// @throws std::invalid_argument as `EncryptionUtils::SASToken` when an argument is empty
+        std::shared_ptr<const Token> get(std::string_view key, std::string_view url, std::string_view keyName)
+        {
+            return get(key, url, keyName, Clock::now());
+        }
+
+
+        /// @brief The token for the entity as of the given time
+        /// @param now The current time; lets callers with a cached clock skip the clock read
+        std::shared_ptr<const Token>
+        get(std::string_view key, std::string_view url, std::string_view keyName, Clock::time_point now)
+        {
+            const EntityKey lookup {url, keyName};
+            auto&           shard = shards[EntityHash {}(lookup) % ShardCount];
+            auto            entry = find(shard, lookup);
+
+            if (!entry) entry = insert(shard, key, url, keyName, now);
+
+            auto token = entry->token.load();
+            if ((now + skew) < token->expiry) return token;
+
+            // Within the skew: one caller regenerates and the others carry on with the current token
+            if (!entry->refreshing.exchange(true, std::memory_order_acquire)) {
+                RunOnEnd resetRefreshing {[&entry] { entry->refreshing.store(false, std::memory_order_release); }};
+
+                // Another caller may have finished refreshing since our load; sign only if the token is still stale
+                token = entry->token.load();
+                if ((now + skew) < token->expiry) return token;
+
+                token = makeToken(key, entry->url, entry->keyName, now);
+                entry->token.store(token);
+                return token;
+            }
+
+            // Expired while another caller is refreshing; this caller cannot wait so it signs its own
+            return (now < token->expiry) ? token : makeToken(key, entry->url, entry->keyName, now);
+        }
+
+
+        /// @brief Drop every cached token; for example after the key is rotated
+        void clear()
+        {
+            for (auto& shard : shards) {
+                std::scoped_lock lock(shard.writer);
+                shard.entries.store({});
+            }
+        }
+
+
+        /// @brief Number of cached entities
+        std::size_t size() const noexcept
+        {
+            std::size_t count = 0;
+
+            for (const auto& shard : shards) {
+                if (auto entries = shard.entries.load(); entries) count += entries->size();
+            }
+            return count;
+        }
+
+    private:
+        /// @brief Number of independently updated maps; a power of two well above the number of writer threads
+        static constexpr std::size_t ShardCount = 64;
+
+        /// @brief Views into the strings owned by the `Entry`
+        using EntityKey = std::pair<std::string_view, std::string_view>;
+
+        struct EntityHash
+        {
+            std::size_t operator()(const EntityKey& key) const noexcept
+            {
+                const auto h = std::hash<std::string_view> {}(key.first);
+                return h ^ (std::hash<std::string_view> {}(key.second) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+            }
+        };
+
+        struct Entry
+        {
+            std::string                 url;
+            std::string                 keyName;
+            SharedSnapshot<const Token> token;
+            std::atomic<bool>           refreshing {false};
+        };
+
+        using EntityMap = std::unordered_map<EntityKey, std::shared_ptr<Entry>, EntityHash>;
+
+        /// @brief Aligned so the writers of neighbouring shards do not share a cache line
+        struct alignas(64) Shard
+        {
+            std::mutex                      writer;
+            SharedSnapshot<const EntityMap> entries;
+        };
+
+
+        static std::shared_ptr<Entry> find(const Shard& shard, const EntityKey& lookup)
+        {
+            if (auto entries = shard.entries.load(); entries) {
+                if (auto it = entries->find(lookup); it != entries->end()) return it->second;
+            }
+            return {};
+        }
+
+
+        /// @brief Publish a new map with the entity added; another thread may have beaten us to it
+        std::shared_ptr<Entry>
+        insert(Shard& shard, std::string_view key, std::string_view url, std::string_view keyName, Clock::time_point now)
+        {
+            auto entry     = std::make_shared<Entry>();
+            entry->url     = url;
+            entry->keyName = keyName;
+            // Sign outside of the lock; losing the race only wastes the signature
+            entry->token.store(makeToken(key, entry->url, entry->keyName, now));
+
+            std::scoped_lock lock(shard.writer);
+
+            auto current = shard.entries.load();
+            if (current) {
+                if (auto it = current->find(EntityKey {url, keyName}); it != current->end()) return it->second;
+            }
+
+            auto updated = current ? std::make_shared<EntityMap>(*current) : std::make_shared<EntityMap>();
+            updated->emplace(EntityKey {entry->url, entry->keyName}, entry);
+            shard.entries.store(std::move(updated));
+            return entry;
+        }
+
+
+        std::shared_ptr<const Token>
+        makeToken(std::string_view key, const std::string& url, const std::string& keyName, Clock::time_point now) const
+        {
+            const auto expiry = std::chrono::time_point_cast<std::chrono::seconds>(now) + lifetime;
+
+#if defined(WIN32) || defined(_WIN32) || defined(_WIN64) || defined(WIN64)
+            // The Windows SASToken takes the key as std::string
+            return std::make_shared<const Token>(Token {
+                    EncryptionUtils::SASToken<char>(
+                            std::string(key), url, keyName, std::to_string(expiry.time_since_epoch().count())),
+                    expiry});
+#else
+            return std::make_shared<const Token>(Token {
+                    EncryptionUtils::SASToken<char>(key, url, keyName, std::to_string(expiry.time_since_epoch().count())),
+                    expiry});
+#endif
+        }
+
+        std::chrono::seconds          lifetime;
+        std::chrono::seconds          skew;
+        std::array<Shard, ShardCount> shards {};
+    };
+} // namespace siddiqsoft
+
+#endif // !SAS_TOKEN_CACHE_HPP
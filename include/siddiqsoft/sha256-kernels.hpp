@@ -0,0 +1,625 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef SHA256_KERNELS_HPP
+#define SHA256_KERNELS_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "cpu-features.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Platform neutral SHA-256 kernels for short messages.
+    ///        The single-buffer kernels hash one message at a time: portable scalar code or the SHA extensions.
+    ///        The multi-buffer kernels run one message per 32-bit vector lane (eight with AVX2, sixteen with AVX-512) so
+    ///        the latency of the serial round chain is hidden behind the other lanes on the same core.
+    ///        The scalar kernel is always available and every kernel produces output identical to it.
+    /// @remarks These are the building blocks for `EncryptionUtils::HMACBatch` and `NativeHmacSha256Signer`; you should not
+    ///          need to call them directly.
+    struct Sha256Kernels
+    {
+        /// @brief The available kernel implementations
+        enum class Kernel
+        {
+            Scalar,
+            SHA,
+            AVX2,
+            AVX512
+        };
+
+
+        static constexpr std::size_t BlockSize  = 64;
+        static constexpr std::size_t DigestSize = 32;
+        /// @brief The most lanes of any kernel
+        static constexpr std::size_t MaxLanes = 16;
+        /// @brief Messages handled per round of `hmacBatch`; bounds its stack use
+        static constexpr std::size_t BatchSize = 64;
+
+        /// @brief The eight working words between blocks
+        using State = std::array<std::uint32_t, 8>;
+
+        static constexpr State InitialState {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+        static constexpr std::array<std::uint32_t, 64> K {
+                0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+
+        /// @brief One message for `hashBatch`.
+        ///        Hashing resumes from `initial` which has already absorbed `prefixLength` bytes (a multiple of the block
+        ///        size); the message is absorbed and the padding applied for the combined length.
+        struct Job
+        {
+            const State*         initial;
+            const unsigned char* data;
+            std::size_t          length;
+            std::uint64_t        prefixLength;
+        };
+
+
+        /// @brief The HMAC key schedule: the states after absorbing the inner and outer padded key blocks
+        struct HmacKey
+        {
+            State inner;
+            State outer;
+        };
+
+
+        static bool isSupported(Kernel kernel) noexcept
+        {
+            const auto& cpu = CpuFeatures::current();
+
+            switch (kernel) {
+                case Kernel::Scalar: return true;
+#if defined(SIDDIQSOFT_X86_64)
+                case Kernel::SHA: return cpu.sha;
+                case Kernel::AVX2: return cpu.avx2;
+                case Kernel::AVX512: return cpu.avx512bw;
+#endif
+                default: return false;
+            }
+        }
+
+
+        /// @brief The widest kernel supported by this CPU for batches; determined once per process
+        static Kernel bestKernel() noexcept
+        {
+            static const Kernel kernel = [] {
+                if (isSupported(Kernel::AVX512)) return Kernel::AVX512;
+                if (isSupported(Kernel::AVX2)) return Kernel::AVX2;
+                return bestSingleKernel();
+            }();
+
+            return kernel;
+        }
+
+
+        /// @brief The fastest single-buffer kernel supported by this CPU; determined once per process
+        static Kernel bestSingleKernel() noexcept
+        {
+            static const Kernel kernel = isSupported(Kernel::SHA) ? Kernel::SHA : Kernel::Scalar;
+
+            return kernel;
+        }
+
+
+        /// @brief Absorb one block into the state
+        static void compress(State& state, const unsigned char* block) noexcept
+        {
+            std::uint32_t w[64];
+
+            for (std::size_t t = 0; t < 16; t++) w[t] = loadBigEndian(block + (t * 4));
+            for (std::size_t t = 16; t < 64; t++) {
+                const auto s0 = std::rotr(w[t - 15], 7) ^ std::rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+                const auto s1 = std::rotr(w[t - 2], 17) ^ std::rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+                w[t]          = w[t - 16] + s0 + w[t - 7] + s1;
+            }
+
+            auto [a, b, c, d, e, f, g, h] = state;
+
+            for (std::size_t t = 0; t < 64; t++) {
+                const auto t1 = h + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+                const auto t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) | (c & (a | b)));
+
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+
+
+        /// @brief Absorb consecutive blocks into the state
+        /// @param kernel A single-buffer kernel supported by this CPU
+        static void compressBlocks(State& state, const unsigned char* data, std::size_t blocks, Kernel kernel) noexcept
+        {
+#if defined(SIDDIQSOFT_X86_64)
+            if (kernel == Kernel::SHA) {
+                compressBlocksSHA(state, data, blocks);
+                return;
+            }
+#endif
+            for (std::size_t block = 0; block < blocks; block++) compress(state, data + (block * BlockSize));
+        }
+
+
+        /// @brief Hash the message with a single-buffer kernel
+        /// @param initial The state to resume from; `InitialState` for a plain digest
+        /// @param prefixLength Bytes already absorbed into `initial`
+        /// @param kernel A single-buffer kernel supported by this CPU
+        static State hash(const State&         initial,
+                          const unsigned char* data,
+                          std::size_t          length,
+                          std::uint64_t        prefixLength = 0,
+                          Kernel               kernel       = bestSingleKernel()) noexcept
+        {
+            State         state = initial;
+            unsigned char tail[2 * BlockSize] {};
+            const auto    fullBlocks = length / BlockSize;
+
+            compressBlocks(state, data, fullBlocks, kernel);
+            compressBlocks(state,
+                           tail,
+                           pad(data + (fullBlocks * BlockSize), length % BlockSize, prefixLength + length, tail),
+                           kernel);
+            return state;
+        }
+
+
+        /// @brief Write the state as the big-endian digest
+        /// @param dest Must have room for `DigestSize` bytes
+        static void toBytes(const State& state, unsigned char* dest) noexcept
+        {
+            for (std::size_t i = 0; i < state.size(); i++) {
+                dest[(i * 4)]     = static_cast<unsigned char>(state[i] >> 24);
+                dest[(i * 4) + 1] = static_cast<unsigned char>(state[i] >> 16);
+                dest[(i * 4) + 2] = static_cast<unsigned char>(state[i] >> 8);
+                dest[(i * 4) + 3] = static_cast<unsigned char>(state[i]);
+            }
+        }
+
+
+        /// @brief Hash every job
+        /// @param results Receives the final state of each job; must have room for `jobs.size()`
+        /// @param kernel Must be supported by this CPU; the single-buffer kernels hash the jobs one after another
+        static void hashBatch(std::span<const Job> jobs, std::span<State> results, Kernel kernel = bestKernel()) noexcept
+        {
+#if defined(SIDDIQSOFT_X86_64)
+            if ((kernel == Kernel::AVX2) || (kernel == Kernel::AVX512)) {
+                const std::size_t lanes = (kernel == Kernel::AVX512) ? 16 : 8;
+
+                for (std::size_t first = 0; first < jobs.size(); first += lanes) {
+                    hashLanes(jobs.subspan(first, std::min(lanes, jobs.size() - first)), results.data() + first, kernel);
+                }
+                return;
+            }
+#endif
+            for (std::size_t i = 0; i < jobs.size(); i++) {
+                results[i] = hash(*jobs[i].initial, jobs[i].data, jobs[i].length, jobs[i].prefixLength, kernel);
+            }
+        }
+
+
+        /// @brief Compute the HMAC-SHA256 key schedule
+        /// @param key Keys longer than the block size are hashed first (RFC 2104)
+        static HmacKey hmacKey(std::span<const std::byte> key) noexcept
+        {
+            unsigned char block[BlockSize] {};
+            HmacKey       schedule {InitialState, InitialState};
+
+            if (key.size() > BlockSize) {
+                toBytes(hash(InitialState, reinterpret_cast<const unsigned char*>(key.data()), key.size()), block);
+            }
+            else if (!key.empty()) {
+                std::memcpy(block, key.data(), key.size());
+            }
+
+            for (auto& ch : block) ch ^= 0x36;
+            compressBlocks(schedule.inner, block, 1, bestSingleKernel());
+            // Flip from the inner pad (0x36) to the outer pad (0x5c)
+            for (auto& ch : block) ch ^= (0x36 ^ 0x5c);
+            compressBlocks(schedule.outer, block, 1, bestSingleKernel());
+            return schedule;
+        }
+
+
+        /// @brief HMAC-SHA256 of one message
+        /// @param dest Must have room for `DigestSize` bytes
+        /// @param kernel A single-buffer kernel supported by this CPU
+        static void hmac(const HmacKey&       key,
+                         const unsigned char* data,
+                         std::size_t          length,
+                         unsigned char*       dest,
+                         Kernel               kernel = bestSingleKernel()) noexcept
+        {
+            unsigned char innerDigest[DigestSize];
+
+            toBytes(hash(key.inner, data, length, BlockSize, kernel), innerDigest);
+            toBytes(hash(key.outer, innerDigest, DigestSize, BlockSize, kernel), dest);
+        }
+
+
+        /// @brief HMAC-SHA256 of each message
+        /// @param keys A single key schedule shared by every message or one per message
+        /// @param digests Receives the signatures; must have room for `messages.size()`
+        /// @param kernel Must be supported by this CPU
+        static void hmacBatch(std::span<const HmacKey>                     keys,
+                              std::span<const std::string_view>            messages,
+                              std::span<std::array<std::byte, DigestSize>> digests,
+                              Kernel                                       kernel = bestKernel()) noexcept
+        {
+            std::array<Job, BatchSize>                                    jobs;
+            std::array<State, BatchSize>                                  states;
+            std::array<std::array<unsigned char, DigestSize>, BatchSize> innerDigests;
+
+            for (std::size_t first = 0; first < messages.size(); first += BatchSize) {
+                const auto count = std::min(BatchSize, messages.size() - first);
+
+                // The inner hash resumes after the inner key block; the outer hash after the outer key block
+                for (std::size_t i = 0; i < count; i++) {
+                    const auto& message = messages[first + i];
+                    jobs[i]             = {&keys[(keys.size() == 1) ? 0 : first + i].inner,
+                                           reinterpret_cast<const unsigned char*>(message.data()),
+                                           message.length(),
+                                           BlockSize};
+                }
+                hashBatch(std::span(jobs).first(count), states, kernel);
+
+                for (std::size_t i = 0; i < count; i++) {
+                    toBytes(states[i], innerDigests[i].data());
+                    jobs[i] = {&keys[(keys.size() == 1) ? 0 : first + i].outer, innerDigests[i].data(), DigestSize, BlockSize};
+                }
+                hashBatch(std::span(jobs).first(count), states, kernel);
+
+                for (std::size_t i = 0; i < count; i++) {
+                    toBytes(states[i], reinterpret_cast<unsigned char*>(digests[first + i].data()));
+                }
+            }
+        }
+
+    private:
+        static std::uint32_t loadBigEndian(const unsigned char* src) noexcept
+        {
+            return (static_cast<std::uint32_t>(src[0]) << 24) | (static_cast<std::uint32_t>(src[1]) << 16) |
+                   (static_cast<std::uint32_t>(src[2]) << 8) | static_cast<std::uint32_t>(src[3]);
+        }
+
+
+        /// @brief Copy the partial block and append the padding and the bit length
+        /// @param n Bytes in the partial block; less than the block size
+        /// @param dest Two zeroed blocks
+        /// @return Number of blocks to absorb (1 or 2)
+        static std::size_t pad(const unsigned char* src, std::size_t n, std::uint64_t totalLength, unsigned char* dest) noexcept
+        {
+            const std::size_t blocks = ((n + 9) > BlockSize) ? 2 : 1;
+            const auto        bits   = totalLength * 8;
+
+            if (n > 0) std::memcpy(dest, src, n);
+            dest[n] = 0x80;
+            for (std::size_t i = 0; i < 8; i++) dest[(blocks * BlockSize) - 1 - i] = static_cast<unsigned char>(bits >> (i * 8));
+            return blocks;
+        }
+
+#if defined(SIDDIQSOFT_X86_64)
+        /// @brief Absorb consecutive blocks using the SHA extensions.
+        ///        The instructions work on the state split as ABEF and CDGH; each `sha256rnds2` performs two rounds.
+        SIDDIQSOFT_TARGET("sha,sse4.1")
+        static void compressBlocksSHA(State& state, const unsigned char* data, std::size_t blocks) noexcept
+        {
+            const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+            // DCBA and HGFE as loaded become ABEF and CDGH
+            const __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data())), 0xb1);
+            const __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state.data() + 4)), 0x1b);
+            __m128i       abef = _mm_alignr_epi8(cdab, efgh, 8);
+            __m128i       cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+            __m128i       w[4];
+
+            for (; blocks > 0; blocks--, data += BlockSize) {
+                const __m128i abefSaved = abef;
+                const __m128i cdghSaved = cdgh;
+
+                for (std::size_t group = 0; group < 16; group++) {
+                    if (group < 4) {
+                        w[group] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + (group * 16))), swap);
+                    }
+                    else {
+                        // W[t-16] + s0(W[t-15]) + W[t-7]; the second step adds s1(W[t-2])
+                        const __m128i partial = _mm_add_epi32(_mm_sha256msg1_epu32(w[group & 3], w[(group + 1) & 3]),
+                                                              _mm_alignr_epi8(w[(group + 3) & 3], w[(group + 2) & 3], 4));
+                        w[group & 3]          = _mm_sha256msg2_epu32(partial, w[(group + 3) & 3]);
+                    }
+
+                    __m128i rounds = _mm_add_epi32(w[group & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&K[group * 4])));
+                    cdgh           = _mm_sha256rnds2_epu32(cdgh, abef, rounds);
+                    rounds         = _mm_shuffle_epi32(rounds, 0x0e);
+                    abef           = _mm_sha256rnds2_epu32(abef, cdgh, rounds);
+                }
+
+                abef = _mm_add_epi32(abef, abefSaved);
+                cdgh = _mm_add_epi32(cdgh, cdghSaved);
+            }
+
+            const __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+            const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data()), _mm_blend_epi16(feba, dchg, 0xf0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(state.data() + 4), _mm_alignr_epi8(dchg, feba, 8));
+        }
+
+
+        // The multi-buffer kernels follow Gueron and Krasnov, "Simultaneous Hashing of Multiple Messages" (JIS 2012).
+        // The state is held word-major (`state[word * MaxLanes + lane]`) so that each working variable is one vector.
+
+        /// @brief Run up to one kernel's width of jobs side by side.
+        ///        Each lane absorbs its message blocks and then its padding blocks; a lane that finishes early keeps
+        ///        hashing its padding block and its state is taken when its own last block completes.
+        static void hashLanes(std::span<const Job> jobs, State* results, Kernel kernel) noexcept
+        {
+            alignas(64) std::uint32_t                  state[8 * MaxLanes] {};
+            alignas(64) unsigned char                  tails[MaxLanes][2 * BlockSize] {};
+            std::array<std::size_t, MaxLanes>          fullBlocks {};
+            std::array<std::size_t, MaxLanes>          totalBlocks {};
+            std::array<const unsigned char*, MaxLanes> blocks {};
+            std::size_t                                rounds = 0;
+
+            for (std::size_t lane = 0; lane < jobs.size(); lane++) {
+                const auto& job       = jobs[lane];
+                const auto  remainder = job.length % BlockSize;
+
+                fullBlocks[lane]  = job.length / BlockSize;
+                totalBlocks[lane] = fullBlocks[lane] +
+                                    pad(job.data + (job.length - remainder), remainder, job.prefixLength + job.length, tails[lane]);
+                rounds            = std::max(rounds, totalBlocks[lane]);
+                for (std::size_t word = 0; word < 8; word++) state[(word * MaxLanes) + lane] = (*job.initial)[word];
+            }
+
+            for (std::size_t block = 0; block < rounds; block++) {
+                // Idle lanes hash their (zeroed) tail; their state is never read
+                for (std::size_t lane = 0; lane < MaxLanes; lane++) {
+                    blocks[lane] = (block < fullBlocks[lane]) ? jobs[lane].data + (block * BlockSize)
+                                   : (block < totalBlocks[lane]) ? tails[lane] + ((block - fullBlocks[lane]) * BlockSize)
+                                                                 : tails[lane];
+                }
+
+                if (kernel == Kernel::AVX512)
+                    compress16AVX512(state, blocks.data());
+                else
+                    compress8AVX2(state, blocks.data());
+
+                for (std::size_t lane = 0; lane < jobs.size(); lane++) {
+                    if ((block + 1) == totalBlocks[lane]) {
+                        for (std::size_t word = 0; word < 8; word++) results[lane][word] = state[(word * MaxLanes) + lane];
+                    }
+                }
+            }
+        }
+
+
+        /// @brief Load 32 bytes at `offset` from each of eight blocks as big-endian words and transpose so that
+        ///        `words[i]` holds word i of every lane
+        SIDDIQSOFT_TARGET("avx2")
+        static void loadWordsAVX2(const unsigned char* const* blocks, std::size_t offset, __m256i* words) noexcept
+        {
+            const __m256i swap =
+                    _mm256_broadcastsi128_si256(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+            __m256i       rows[8];
+
+            for (std::size_t lane = 0; lane < 8; lane++) {
+                rows[lane] = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + offset)), swap);
+            }
+
+            const __m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+            const __m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+            const __m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+            const __m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+            const __m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+            const __m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+            const __m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+            const __m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+            const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+            const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+            const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+            const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+            const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+            const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+            const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+            const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+            words[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+            words[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+            words[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+            words[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+            words[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+            words[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+            words[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+            words[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+        }
+
+
+        template <int N>
+        SIDDIQSOFT_TARGET("avx2")
+        static __m256i rotrAVX2(__m256i x) noexcept
+        {
+            return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static void compress8AVX2(std::uint32_t* state, const unsigned char* const* blocks) noexcept
+        {
+            __m256i w[16];
+            __m256i v[8];
+
+            loadWordsAVX2(blocks, 0, w);
+            loadWordsAVX2(blocks, 32, w + 8);
+            for (std::size_t word = 0; word < 8; word++) {
+                v[word] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state + (word * MaxLanes)));
+            }
+
+            __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+            for (std::size_t t = 0; t < 64; t++) {
+                if (t >= 16) {
+                    const __m256i w15 = w[(t - 15) & 15];
+                    const __m256i w2  = w[(t - 2) & 15];
+                    const __m256i s0  = _mm256_xor_si256(_mm256_xor_si256(rotrAVX2<7>(w15), rotrAVX2<18>(w15)),
+                                                         _mm256_srli_epi32(w15, 3));
+                    const __m256i s1  = _mm256_xor_si256(_mm256_xor_si256(rotrAVX2<17>(w2), rotrAVX2<19>(w2)),
+                                                         _mm256_srli_epi32(w2, 10));
+                    w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+                }
+
+                const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotrAVX2<6>(e), rotrAVX2<11>(e)), rotrAVX2<25>(e));
+                const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+                const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, s1), ch),
+                                                    _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(K[t])), w[t & 15]));
+                const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotrAVX2<2>(a), rotrAVX2<13>(a)), rotrAVX2<22>(a));
+                const __m256i mj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+
+                h = g;
+                g = f;
+                f = e;
+                e = _mm256_add_epi32(d, t1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm256_add_epi32(t1, _mm256_add_epi32(s0, mj));
+            }
+
+            const __m256i out[8] {a, b, c, d, e, f, g, h};
+            for (std::size_t word = 0; word < 8; word++) {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(state + (word * MaxLanes)), _mm256_add_epi32(v[word], out[word]));
+            }
+        }
+
+
+        SIDDIQSOFT_TARGET("avx512f")
+        static void compress16AVX512(std::uint32_t* state, const unsigned char* const* blocks) noexcept
+        {
+            __m256i lo[16];
+            __m256i hi[16];
+            __m512i w[16];
+            __m512i v[8];
+
+            // Transpose each half of the lanes as for AVX2 and join them
+            loadWordsAVX2(blocks, 0, lo);
+            loadWordsAVX2(blocks, 32, lo + 8);
+            loadWordsAVX2(blocks + 8, 0, hi);
+            loadWordsAVX2(blocks + 8, 32, hi + 8);
+            for (std::size_t word = 0; word < 16; word++) {
+                w[word] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[word]), hi[word], 1);
+            }
+            for (std::size_t word = 0; word < 8; word++) {
+                v[word] = _mm512_load_si512(reinterpret_cast<const __m512i*>(state + (word * MaxLanes)));
+            }
+
+            __m512i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+            // The ternary logic immediates: 0x96 is a ^ b ^ c, 0xca is a ? b : c (Ch) and 0xe8 is the majority (Maj)
+            for (std::size_t t = 0; t < 64; t++) {
+                if (t >= 16) {
+                    const __m512i w15 = w[(t - 15) & 15];
+                    const __m512i w2  = w[(t - 2) & 15];
+                    const __m512i s0  = _mm512_ternarylogic_epi32(
+                            _mm512_ror_epi32(w15, 7), _mm512_ror_epi32(w15, 18), _mm512_srli_epi32(w15, 3), 0x96);
+                    const __m512i s1  = _mm512_ternarylogic_epi32(
+                            _mm512_ror_epi32(w2, 17), _mm512_ror_epi32(w2, 19), _mm512_srli_epi32(w2, 10), 0x96);
+                    w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0), _mm512_add_epi32(w[(t - 7) & 15], s1));
+                }
+
+                const __m512i s1 =
+                        _mm512_ternarylogic_epi32(_mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25), 0x96);
+                const __m512i ch = _mm512_ternarylogic_epi32(e, f, g, 0xca);
+                const __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(_mm512_add_epi32(h, s1), ch),
+                                                    _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(K[t])), w[t & 15]));
+                const __m512i s0 =
+                        _mm512_ternarylogic_epi32(_mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22), 0x96);
+                const __m512i mj = _mm512_ternarylogic_epi32(a, b, c, 0xe8);
+
+                h = g;
+                g = f;
+                f = e;
+                e = _mm512_add_epi32(d, t1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm512_add_epi32(t1, _mm512_add_epi32(s0, mj));
+            }
+
+            const __m512i out[8] {a, b, c, d, e, f, g, h};
+            for (std::size_t word = 0; word < 8; word++) {
+                _mm512_store_si512(reinterpret_cast<__m512i*>(state + (word * MaxLanes)), _mm512_add_epi32(v[word], out[word]));
+            }
+        }
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !SHA256_KERNELS_HPP
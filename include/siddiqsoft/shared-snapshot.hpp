@@ -0,0 +1,85 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef SHARED_SNAPSHOT_HPP
+#define SHARED_SNAPSHOT_HPP
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief A `std::shared_ptr` which may be read and replaced concurrently; readers never block each other.
+    /// @remarks Uses `std::atomic<std::shared_ptr>` where the standard library provides it.
+    template <typename T>
+    class SharedSnapshot
+    {
+    public:
+        std::shared_ptr<T> load() const noexcept
+        {
+#if defined(__cpp_lib_atomic_shared_ptr)
+            return value.load(std::memory_order_acquire);
+#else
+            return std::atomic_load_explicit(&value, std::memory_order_acquire);
+#endif
+        }
+
+
+        void store(std::shared_ptr<T> replacement) noexcept
+        {
+#if defined(__cpp_lib_atomic_shared_ptr)
+            value.store(std::move(replacement), std::memory_order_release);
+#else
+            std::atomic_store_explicit(&value, std::move(replacement), std::memory_order_release);
+#endif
+        }
+
+    private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+        std::atomic<std::shared_ptr<T>> value {};
+#else
+        std::shared_ptr<T> value {};
+#endif
+    };
+} // namespace siddiqsoft
+
+#endif // !SHARED_SNAPSHOT_HPP
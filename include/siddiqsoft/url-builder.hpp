@@ -0,0 +1,225 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#pragma once
+
+#ifndef URL_BUILDER_HPP
+#define URL_BUILDER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "appendable-buffer.hpp"
+#include "url-utils.hpp"
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Assemble a request URL from its parts and write it, encoded, with a single allocation.
+    ///        The parts are held as views; the exact encoded length is known before anything is written.
+    /// @remarks The builder does not copy the strings handed to it; they must outlive the builder.
+    ///          Path segments are encoded with `UrlUtils::PathSegment`, paths with `UrlUtils::Path` and the query keys and
+    ///          values with `UrlUtils::QueryValue`. The scheme and host are written as-is.
+    class UrlBuilder
+    {
+    public:
+        /// @brief Start a URL
+        /// @param urlScheme For example "https"; when empty the URL starts with the host
+        /// @param urlHost For example "myaccount.blob.core.windows.net"; may be empty for a path-only URL
+        explicit UrlBuilder(std::string_view urlScheme = {}, std::string_view urlHost = {}) noexcept
+            : scheme(urlScheme)
+            , host(urlHost)
+        {
+        }
+
+
+        /// @brief Append a single path segment; a "/" within the segment is escaped
+        /// @param value The unencoded segment
+        UrlBuilder& segment(std::string_view value)
+        {
+            pathParts.emplace_back(value, true);
+            return *this;
+        }
+
+
+        /// @brief Append one or more path segments; "/" is kept as the separator and a leading "/" is added when missing
+        /// @param value The unencoded path; for example a blob name "folder/file.txt"
+        UrlBuilder& path(std::string_view value)
+        {
+            pathParts.emplace_back(value, false);
+            return *this;
+        }
+
+
+        /// @brief Append a query parameter
+        /// @param key The unencoded key
+        /// @param value The unencoded value
+        UrlBuilder& query(std::string_view key, std::string_view value)
+        {
+            if (sortQuery) {
+                // Keep the order canonical as we go
+                queryParts.emplace(std::ranges::upper_bound(queryParts, std::pair {key, value}), key, value);
+            }
+            else {
+                queryParts.emplace_back(key, value);
+            }
+            return *this;
+        }
+
+
+        /// @brief Order the query parameters by key (and then value) as required for canonicalized signing
+        /// @param sort When false the parameters added from now on keep their insertion order
+        UrlBuilder& canonicalQuery(bool sort = true)
+        {
+            if ((sortQuery = sort)) std::ranges::stable_sort(queryParts);
+            return *this;
+        }
+
+
+        /// @brief Exact length of the encoded URL
+        std::size_t size() const noexcept
+        {
+            std::size_t length = host.length() + (scheme.empty() ? 0 : scheme.length() + 3);
+
+            for (const auto& [value, single] : pathParts) {
+                length += (single || !value.starts_with('/')) ? 1 : 0;
+                length += single ? UrlUtils::encodedLength<UrlUtils::PathSegment<>>(value)
+                                 : UrlUtils::encodedLength<UrlUtils::Path<>>(value);
+            }
+
+            // Each parameter contributes its "?" or "&" and "="
+            for (const auto& [key, value] : queryParts) {
+                length += 2 + UrlUtils::encodedLength<UrlUtils::QueryValue<>>(key) +
+                          UrlUtils::encodedLength<UrlUtils::QueryValue<>>(value);
+            }
+
+            return length;
+        }
+
+
+        /// @brief Write the encoded URL into a caller-provided buffer
+        /// @param dest Must have room for `size()` characters
+        /// @return Number of characters written
+        /// @throws std::invalid_argument if the destination is too small
+        std::size_t writeTo(std::span<char> dest) const
+        {
+            const auto length = size();
+
+            if (dest.size() < length)
+                throw std::invalid_argument(
+                        std::format("Destination requires {} characters; only {} available", length, dest.size()));
+
+            write(dest.data());
+            return length;
+        }
+
+
+        /// @brief Append the encoded URL to the buffer
+        /// @param dest Buffer to append; for example std::string or std::vector<char>
+        /// @return Number of characters appended
+        template <AppendableBuffer B>
+        std::size_t writeTo(B& dest) const
+        {
+            const auto start  = dest.size();
+            const auto length = size();
+
+            dest.resize(start + length);
+            write(reinterpret_cast<char*>(dest.data()) + start);
+            return length;
+        }
+
+
+        /// @brief The encoded URL
+        std::string str() const
+        {
+            std::string retOutput(size(), 0);
+
+            write(retOutput.data());
+            return retOutput;
+        }
+
+    private:
+        /// @brief Write the URL; `dst` has room for `size()` characters
+        void write(char* dst) const noexcept
+        {
+            // A default std::string_view has a null data(); memcpy may not be handed one even for zero bytes
+            auto copy = [&dst](std::string_view value) {
+                if (value.empty()) return;
+                std::memcpy(dst, value.data(), value.length());
+                dst += value.length();
+            };
+
+            if (!scheme.empty()) {
+                copy(scheme);
+                copy("://");
+            }
+            copy(host);
+
+            for (const auto& [value, single] : pathParts) {
+                if (single || !value.starts_with('/')) *dst++ = '/';
+                dst = single ? UrlUtils::escape<UrlUtils::PathSegment<>>(value.data(), value.length(), dst)
+                             : UrlUtils::escape<UrlUtils::Path<>>(value.data(), value.length(), dst);
+            }
+
+            char separator = '?';
+            for (const auto& [key, value] : queryParts) {
+                *dst++    = separator;
+                separator = '&';
+                dst       = UrlUtils::escape<UrlUtils::QueryValue<>>(key.data(), key.length(), dst);
+                *dst++    = '=';
+                dst       = UrlUtils::escape<UrlUtils::QueryValue<>>(value.data(), value.length(), dst);
+            }
+        }
+
+        std::string_view scheme {};
+        std::string_view host {};
+        /// @brief The path parts; the flag is set for a single segment
+        std::vector<std::pair<std::string_view, bool>>             pathParts {};
+        std::vector<std::pair<std::string_view, std::string_view>> queryParts {};
+        bool                                                       sortQuery {false};
+    };
+} // namespace siddiqsoft
+
+#endif // !URL_BUILDER_HPP
@@ -40,10 +40,21 @@
 
 
 #include <string>
+#include <string_view>
 #include <concepts>
 #include <format>
 #include <ranges>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#include "appendable-buffer.hpp"
+#include "cpu-features.hpp"
+#include "utf8-utils.hpp"
 
 /// @brief SiddiqSoft
 namespace siddiqsoft
@@ -68,6 +79,104 @@ namespace siddiqsoft
     /// @brief Url encode function
     struct UrlUtils
     {
+        /// @brief Set of characters which are copied as-is; everything else is percent-encoded
+        struct CharacterSet
+        {
+            /// @brief Indexed by the byte value
+            std::array<bool, 256> allowed;
+            /// @brief Bit `h` of entry `l` is set when the character `(h * 16) + l` is allowed; drives the vector scanners
+            alignas(16) std::array<uint8_t, 16> bitmap;
+        };
+
+
+        /// @brief Build a set from the alphanumerics and the given (ASCII) characters
+        static constexpr auto makeCharacterSet = [](std::string_view extra) {
+            CharacterSet set {};
+
+            auto allow = [&set](unsigned char ch) {
+                set.allowed[ch] = true;
+                set.bitmap[ch & 0x0f] |= static_cast<uint8_t>(1u << (ch >> 4));
+            };
+
+            for (unsigned char ch = '0'; ch <= '9'; ch++) allow(ch);
+            for (unsigned char ch = 'A'; ch <= 'Z'; ch++) allow(ch);
+            for (unsigned char ch = 'a'; ch <= 'z'; ch++) allow(ch);
+            for (char ch : extra) allow(static_cast<unsigned char>(ch));
+            return set;
+        };
+
+
+        /// @brief RFC 3986 §2.3 unreserved characters: ALPHA / DIGIT / "-" / "." / "_" / "~"
+        static constexpr CharacterSet Unreserved = makeCharacterSet("-._~");
+        /// @brief RFC 3986 §3.3 pchar: unreserved / sub-delims / ":" / "@"
+        static constexpr CharacterSet PathSegmentSafe = makeCharacterSet("-._~!$&'()*+,;=:@");
+        /// @brief pchar and the "/" separator; for blob names and other multi-segment paths
+        static constexpr CharacterSet PathSafe = makeCharacterSet("-._~!$&'()*+,;=:@/");
+        /// @brief RFC 3986 §3.4 query characters less "&", "=" and "+" which delimit or alter a key/value pair
+        static constexpr CharacterSet QueryValueSafe = makeCharacterSet("-._~!$'()*,;:@/?");
+        /// @brief WHATWG application/x-www-form-urlencoded; space is written as "+"
+        static constexpr CharacterSet FormSafe = makeCharacterSet("*-._");
+
+        static constexpr char HexUpper[17] = "0123456789ABCDEF";
+        static constexpr char HexLower[17] = "0123456789abcdef";
+
+
+        /// @brief Compile-time encoding policy: the characters copied as-is, the hex case and the treatment of space
+        /// @tparam Set The characters which are not escaped
+        /// @tparam LowerCase Emit lowercase hex digits
+        /// @tparam SpaceAsPlus Write space as "+" rather than "%20"
+        template <const CharacterSet& Set, bool LowerCase = false, bool SpaceAsPlus = false>
+        struct EncodingPolicy
+        {
+            static constexpr const CharacterSet& Allowed   = Set;
+            static constexpr const char*         Hex       = LowerCase ? HexLower : HexUpper;
+            static constexpr bool                SpacePlus = SpaceAsPlus;
+        };
+
+        /// @brief Only the unreserved characters are left as-is; the default for `encode`
+        template <bool LowerCase = false>
+        using Component = EncodingPolicy<Unreserved, LowerCase>;
+        /// @brief A single path segment; "/" is escaped
+        template <bool LowerCase = false>
+        using PathSegment = EncodingPolicy<PathSegmentSafe, LowerCase>;
+        /// @brief A path of one or more segments; "/" is left as-is
+        template <bool LowerCase = false>
+        using Path = EncodingPolicy<PathSafe, LowerCase>;
+        /// @brief A query key or value
+        template <bool LowerCase = false>
+        using QueryValue = EncodingPolicy<QueryValueSafe, LowerCase>;
+        /// @brief An application/x-www-form-urlencoded key or value
+        template <bool LowerCase = false>
+        using Form = EncodingPolicy<FormSafe, LowerCase, true>;
+
+        /// @brief Value of a hex digit (either case); 0xff for anything else
+        static constexpr std::array<uint8_t, 256> HexValue = [] {
+            std::array<uint8_t, 256> table {};
+
+            table.fill(0xff);
+            for (uint8_t i = 0; i < 16; i++) {
+                table[static_cast<unsigned char>(HexUpper[i])] = i;
+                table[static_cast<unsigned char>(HexLower[i])] = i;
+            }
+            return table;
+        }();
+
+
+        /// @brief Marker for "no error" in `DecodeResult::errorOffset`
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// @brief Outcome of a decode operation
+        struct DecodeResult
+        {
+            /// @brief Number of characters written to the destination
+            std::size_t written {0};
+            /// @brief Offset of the `%` which starts a malformed escape or `npos` on success
+            std::size_t errorOffset {npos};
+
+            explicit operator bool() const noexcept { return errorOffset == npos; }
+        };
+
+
         /**
          * @brief Helper to encode the given string in context of the HTTP url.
          *        This function always encodes in UTF-8 despite the container
@@ -79,31 +188,518 @@ namespace siddiqsoft
          */
         template <typename T = char>
             requires std::same_as<T, char> || std::same_as<T, wchar_t>
-        static std::basic_string<T> encode(const std::basic_string<T>& source, bool lowerCase = false)
+        static std::basic_string<T> encode(std::type_identity_t<std::basic_string_view<T>> source, bool lowerCase = false)
         {
-            std::basic_string<T> retOutput {};
+            return lowerCase ? encode<Component<true>, T>(source) : encode<Component<false>, T>(source);
+        }
+
 
+        /// @brief Url encode; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> encode(const std::basic_string<T, Traits, Alloc>& source, bool lowerCase = false)
+        {
+            return encode<T>(std::basic_string_view<T>(source), lowerCase);
+        }
+
+
+        /**
+         * @brief Encode the given string for a particular part of the URL.
+         *        This function always encodes in UTF-8 despite the container
+         *
+         * @tparam Policy One of `Component`, `PathSegment`, `Path`, `QueryValue`, `Form` (or an `EncodingPolicy`)
+         * @tparam T char or wchar_t
+         * @param source Source string to encode
+         * @return Encoded string
+         */
+        template <typename Policy, typename T = char>
+            requires(std::same_as<T, char> || std::same_as<T, wchar_t>) && requires {
+                Policy::Allowed;
+                Policy::Hex;
+                Policy::SpacePlus;
+            }
+        static std::basic_string<T> encode(std::type_identity_t<std::basic_string_view<T>> source)
+        {
             if constexpr (std::is_same_v<T, char>) {
-                std::ranges::for_each(source, [&retOutput, &lowerCase](T ch) {
-                    if ((((ch >= 48) && (ch <= 57)) || ((ch >= 65) && (ch <= 90)) || ((ch >= 97) && (ch <= 122))) ||
-                        ((ch == '.') || (ch == '-') || (ch == '~') || (ch == '_')))
-                    {
-                        // Takes care of 0-9, A-Z and a-z as well as some
-                        // Other special cases
-                        std::format_to(std::back_inserter(retOutput), "{}", ch);
+                // Count first so the output is allocated exactly once; most keys and resource ids need no escapes at all.
+                const auto escaped = countEscaped(source.data(), source.length(), Policy::Allowed);
+                if (escaped == 0) return std::basic_string<T>(source);
+
+                std::basic_string<T> retOutput(source.length() + (2 * escaped), 0);
+                auto                 end = escape<Policy>(source.data(), source.length(), retOutput.data());
+                // Only shorter than sized when spaces were written as "+"
+                if constexpr (Policy::SpacePlus) retOutput.resize(static_cast<std::size_t>(end - retOutput.data()));
+                return retOutput;
+            }
+            else {
+                // Fused: each code point is transcoded to UTF-8 on the fly and its escapes are written straight to the
+                // wide output. Lone surrogates and out of range units are encoded as U+FFFD.
+                const wchar_t* end      = source.data() + source.length();
+                std::size_t    length   = 0;
+                bool           verbatim = true;
+
+                for (const wchar_t* src = source.data(); src < end;) {
+                    const auto cp = Utf8Utils::nextCodePoint(src, end);
+
+                    if ((cp < 0x80) && Policy::Allowed.allowed[cp]) {
+                        length++;
+                        continue;
+                    }
+
+                    verbatim = false;
+                    length += (Policy::SpacePlus && (cp == U' ')) ? 1 : 3 * Utf8Utils::codePointLength(cp);
+                }
+
+                if (verbatim) return std::basic_string<T>(source);
+
+                std::basic_string<T> retOutput(length, 0);
+                auto                 out = retOutput.data();
+
+                for (const wchar_t* src = source.data(); src < end;) {
+                    const auto cp = Utf8Utils::nextCodePoint(src, end);
+
+                    if ((cp < 0x80) && Policy::Allowed.allowed[cp]) {
+                        *out++ = static_cast<wchar_t>(cp);
+                    }
+                    else if (Policy::SpacePlus && (cp == U' ')) {
+                        *out++ = L'+';
                     }
                     else {
-                        lowerCase ? std::format_to(std::back_inserter(retOutput), "%{:02x}", ch)
-                                  : std::format_to(std::back_inserter(retOutput), "%{:02X}", ch);
-                    };
-                });
+                        unsigned char utf8[4];
+                        const auto    count = Utf8Utils::encodeCodePoint(cp, utf8);
+
+                        for (std::size_t i = 0; i < count; i++) {
+                            *out++ = L'%';
+                            *out++ = static_cast<wchar_t>(Policy::Hex[utf8[i] >> 4]);
+                            *out++ = static_cast<wchar_t>(Policy::Hex[utf8[i] & 0x0f]);
+                        }
+                    }
+                }
+
+                return retOutput;
+            }
+        }
+
+
+        /// @brief Encode for a particular part of the URL; forwards to the `std::basic_string_view` overload
+        template <typename Policy, typename T, typename Traits, typename Alloc>
+            requires(std::same_as<T, char> || std::same_as<T, wchar_t>) && requires {
+                Policy::Allowed;
+                Policy::Hex;
+                Policy::SpacePlus;
+            }
+        static std::basic_string<T> encode(const std::basic_string<T, Traits, Alloc>& source)
+        {
+            return encode<Policy, T>(std::basic_string_view<T>(source));
+        }
+
+
+        /// @brief Encode the bytes for a particular part of the URL
+        /// @tparam Policy One of `Component`, `PathSegment`, `Path`, `QueryValue`, `Form` (or an `EncodingPolicy`)
+        /// @param source The bytes to encode
+        /// @return Encoded string
+        template <typename Policy = Component<>>
+            requires requires {
+                Policy::Allowed;
+                Policy::Hex;
+                Policy::SpacePlus;
+            }
+        static std::string encode(std::span<const std::byte> source)
+        {
+            return encode<Policy, char>(std::string_view(reinterpret_cast<const char*>(source.data()), source.size()));
+        }
+
+
+        /// @brief Exact length of `source` once encoded with the policy
+        template <typename Policy>
+        static std::size_t encodedLength(std::string_view source) noexcept
+        {
+            auto length = source.length() + (2 * countEscaped(source.data(), source.length(), Policy::Allowed));
+
+            if constexpr (Policy::SpacePlus) length -= 2 * static_cast<std::size_t>(std::ranges::count(source, ' '));
+            return length;
+        }
+
+
+        /// @brief Decode a percent-encoded string
+        /// @tparam T char or wchar_t
+        /// @param source The url-encoded string; the escapes are decoded as UTF-8
+        /// @param formEncoded Decode `+` as space (application/x-www-form-urlencoded)
+        /// @return Decoded string; empty if there is a malformed escape
+        template <typename T = char>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(std::type_identity_t<std::basic_string_view<T>> source, bool formEncoded = false)
+        {
+            std::size_t errorOffset {};
+            return decode<T>(source, errorOffset, formEncoded);
+        }
+
+
+        /// @brief Decode a percent-encoded string; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T> decode(const std::basic_string<T, Traits, Alloc>& source, bool formEncoded = false)
+        {
+            return decode<T>(std::basic_string_view<T>(source), formEncoded);
+        }
+
+
+        /// @brief Decode a percent-encoded string and report where it failed
+        /// @tparam T char or wchar_t
+        /// @param source The url-encoded string; the escapes are decoded as UTF-8
+        /// @param errorOffset Receives the offset of the `%` which starts the first malformed escape or `npos` on success
+        /// @param formEncoded Decode `+` as space (application/x-www-form-urlencoded)
+        /// @return Decoded string; empty if there is a malformed escape
+        template <typename T = char>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T>
+        decode(std::type_identity_t<std::basic_string_view<T>> source, std::size_t& errorOffset, bool formEncoded = false)
+        {
+            if constexpr (std::is_same_v<T, char>) {
+                // Escapes only ever shrink the output so we decode into a copy-sized buffer and trim
+                std::basic_string<T> retOutput(source.length(), 0);
+
+                auto result = unescape(source.data(), source.length(), retOutput.data(), formEncoded);
+                errorOffset = result.errorOffset;
+                if (!result) return {};
+
+                retOutput.resize(result.written);
+                return retOutput;
             }
             else {
-                return ConversionUtils::convert_to<char, T>(encode(ConversionUtils::convert_to<T, char>(source), lowerCase));
+                // Transcode once to UTF-8, unescape in place and transcode the result back
+                std::string narrow(Utf8Utils::encodedLength(source), 0);
+                auto        out = reinterpret_cast<unsigned char*>(narrow.data());
+                for (const wchar_t *src = source.data(), *end = src + source.length(); src < end;) {
+                    out += Utf8Utils::encodeCodePoint(Utf8Utils::nextCodePoint(src, end), out);
+                }
+
+                auto result = unescape(narrow.data(), narrow.length(), narrow.data(), formEncoded);
+                if (!result) {
+                    // Report the offset within the wide source; everything ahead of it is counted in UTF-8 bytes
+                    unsigned char  scratch[4];
+                    const wchar_t *src = source.data(), *end = src + source.length();
+                    for (std::size_t bytes = 0; bytes < result.errorOffset;) {
+                        bytes += Utf8Utils::encodeCodePoint(Utf8Utils::nextCodePoint(src, end), scratch);
+                    }
+                    errorOffset = static_cast<std::size_t>(src - source.data());
+                    return {};
+                }
+
+                std::basic_string<T> retOutput(result.written, 0);
+                std::size_t          consumed = 0;
+                retOutput.resize(Utf8Utils::toWide(reinterpret_cast<const unsigned char*>(narrow.data()),
+                                                   result.written,
+                                                   retOutput.data(),
+                                                   true,
+                                                   consumed));
+                errorOffset = npos;
+                return retOutput;
+            }
+        }
+
+
+        /// @brief Decode a percent-encoded string and report where it failed; forwards to the `std::basic_string_view` overload
+        template <typename T, typename Traits, typename Alloc>
+            requires std::same_as<T, char> || std::same_as<T, wchar_t>
+        static std::basic_string<T>
+        decode(const std::basic_string<T, Traits, Alloc>& source, std::size_t& errorOffset, bool formEncoded = false)
+        {
+            return decode<T>(std::basic_string_view<T>(source), errorOffset, formEncoded);
+        }
+
+
+        /// @brief Decode a percent-encoded string into a caller-provided buffer
+        /// @param source The url-encoded string
+        /// @param dest Must have room for `source.size()` characters (the decoded value is never longer)
+        /// @param formEncoded Decode `+` as space (application/x-www-form-urlencoded)
+        /// @return The number of characters written and, on failure, the offset of the malformed escape
+        /// @throws std::invalid_argument if the destination is too small
+        static DecodeResult decodeInto(std::string_view source, std::span<char> dest, bool formEncoded = false)
+        {
+            if (dest.size() < source.size())
+                throw std::invalid_argument(
+                        std::format("Destination requires {} characters; only {} available", source.size(), dest.size()));
+
+            return unescape(source.data(), source.size(), dest.data(), formEncoded);
+        }
+
+
+        /// @brief Decode a percent-encoded string and append to the buffer. On failure the buffer is left as it was.
+        /// @param source The url-encoded string
+        /// @param dest Buffer to append; for example std::string or std::vector<char>
+        /// @param formEncoded Decode `+` as space (application/x-www-form-urlencoded)
+        /// @return The number of characters appended and, on failure, the offset of the malformed escape
+        template <AppendableBuffer B>
+        static DecodeResult decodeInto(std::string_view source, B& dest, bool formEncoded = false)
+        {
+            const auto start = dest.size();
+
+            dest.resize(start + source.size());
+            auto result = unescape(source.data(), source.size(), reinterpret_cast<char*>(dest.data()) + start, formEncoded);
+            dest.resize(result ? (start + result.written) : start);
+            return result;
+        }
+
+
+        /// @brief Decode the percent-escapes (and optionally `+`) from `src` into `dst`
+        /// @param dst Must have room for `n` characters; may be the same as `src` to decode in place
+        /// @return The number of characters written and, on failure, the offset of the malformed escape
+        static DecodeResult unescape(const char* src, std::size_t n, char* dst, bool formEncoded) noexcept
+        {
+            char*       out = dst;
+            std::size_t i   = 0;
+
+            while (i < n) {
+                // Move the run of plain characters in one go; memmove as the decode may be in place
+                const auto run = plainRun(src + i, n - i, formEncoded);
+                std::memmove(out, src + i, run);
+                out += run;
+                i += run;
+
+                if (i >= n) break;
+                if (src[i] == '+') {
+                    *out++ = ' ';
+                    i++;
+                    continue;
+                }
+
+                // Truncated escape
+                if ((i + 2) >= n) return {static_cast<std::size_t>(out - dst), i};
+
+                const uint8_t high = HexValue[static_cast<unsigned char>(src[i + 1])];
+                const uint8_t low  = HexValue[static_cast<unsigned char>(src[i + 2])];
+                if ((high | low) & 0x80) return {static_cast<std::size_t>(out - dst), i};
+
+                *out++ = static_cast<char>((high << 4) | low);
+                i += 3;
             }
 
-            return retOutput;
+            return {static_cast<std::size_t>(out - dst), npos};
         }
+
+
+        /// @brief Length of the leading run without `%` (or `+` when form encoded)
+        static std::size_t plainRun(const char* src, std::size_t n, bool formEncoded) noexcept
+        {
+            std::size_t i = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            if (n >= 16) {
+                if (CpuFeatures::current().avx2)
+                    i = plainRunAVX2(src, n, formEncoded);
+                else
+                    i = plainRunSSE2(src, n, formEncoded);
+            }
+#endif
+
+            while ((i < n) && (src[i] != '%') && (!formEncoded || (src[i] != '+'))) i++;
+            return i;
+        }
+
+
+        /// @brief Percent-encode every byte outside of the policy's set
+        /// @param dst Must have room for `n + (2 * countEscaped(src, n, Policy::Allowed))` characters
+        /// @return One past the last character written
+        template <typename Policy>
+        static char* escape(const char* src, std::size_t n, char* dst) noexcept
+        {
+            constexpr const CharacterSet& set = Policy::Allowed;
+            std::size_t                   i   = 0;
+
+            while (i < n) {
+                // Copy the run of allowed characters in one go
+                const auto run = allowedRun(src + i, n - i, set);
+                std::memcpy(dst, src + i, run);
+                dst += run;
+                i += run;
+
+                for (; (i < n) && !set.allowed[static_cast<unsigned char>(src[i])]; i++) {
+                    const auto ch = static_cast<unsigned char>(src[i]);
+
+                    if constexpr (Policy::SpacePlus) {
+                        if (ch == ' ') {
+                            *dst++ = '+';
+                            continue;
+                        }
+                    }
+
+                    *dst++ = '%';
+                    *dst++ = Policy::Hex[ch >> 4];
+                    *dst++ = Policy::Hex[ch & 0x0f];
+                }
+            }
+
+            return dst;
+        }
+
+
+        /// @brief Number of bytes outside of the set (each of which expands to three characters)
+        static std::size_t countEscaped(const char* src, std::size_t n, const CharacterSet& set) noexcept
+        {
+            std::size_t count = 0;
+            std::size_t i     = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            if (CpuFeatures::current().avx2)
+                i = countEscapedAVX2(src, n, set, count);
+            else if (CpuFeatures::current().sse41)
+                i = countEscapedSSE41(src, n, set, count);
+#endif
+
+            for (; i < n; i++) count += !set.allowed[static_cast<unsigned char>(src[i])];
+            return count;
+        }
+
+
+        /// @brief Length of the leading run of characters in the set
+        static std::size_t allowedRun(const char* src, std::size_t n, const CharacterSet& set) noexcept
+        {
+            std::size_t i = 0;
+
+#if defined(SIDDIQSOFT_X86_64)
+            // Short runs are common (e.g. between multibyte characters); only fire up the vector units for longer input
+            if ((n >= 16) && set.allowed[static_cast<unsigned char>(src[0])]) {
+                if (CpuFeatures::current().avx2)
+                    i = allowedRunAVX2(src, n, set);
+                else if (CpuFeatures::current().sse41)
+                    i = allowedRunSSE41(src, n, set);
+            }
+#endif
+
+            while ((i < n) && set.allowed[static_cast<unsigned char>(src[i])]) i++;
+            return i;
+        }
+
+#if defined(SIDDIQSOFT_X86_64)
+        // Set membership for 16 (or 32) bytes at a time: the low nibble selects a row of the bitmap and the high nibble
+        // selects the bit within the row. Bytes >= 0x80 select no bit and are never members.
+
+        /// @brief Bit `i` is set when byte `i` must be escaped
+        SIDDIQSOFT_TARGET("sse4.1")
+        static uint32_t escapeMaskSSE41(__m128i in, __m128i bitmap) noexcept
+        {
+            const __m128i rowBits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i nibble  = _mm_set1_epi8(0x0f);
+            const __m128i row     = _mm_shuffle_epi8(bitmap, _mm_and_si128(in, nibble));
+            const __m128i bit     = _mm_shuffle_epi8(rowBits, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128())));
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static uint32_t escapeMaskAVX2(__m256i in, __m256i bitmap) noexcept
+        {
+            const __m256i rowBits =
+                    _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0));
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+            const __m256i row    = _mm256_shuffle_epi8(bitmap, _mm256_and_si256(in, nibble));
+            const __m256i bit    = _mm256_shuffle_epi8(rowBits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+
+            return static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256())));
+        }
+
+
+        /// @brief Scan for `%` (and `+`); SSE2 is part of the x86-64 baseline
+        static std::size_t plainRunSSE2(const char* src, std::size_t n, bool formEncoded) noexcept
+        {
+            const __m128i percent = _mm_set1_epi8('%');
+            // When not form encoded compare against `%` twice rather than branch in the loop
+            const __m128i plus = _mm_set1_epi8(formEncoded ? '+' : '%');
+            std::size_t   i    = 0;
+
+            for (; (i + 16) <= n; i += 16) {
+                const __m128i in   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                const auto    mask = static_cast<uint32_t>(
+                        _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(in, percent), _mm_cmpeq_epi8(in, plus))));
+                if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+            }
+
+            return i;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t plainRunAVX2(const char* src, std::size_t n, bool formEncoded) noexcept
+        {
+            const __m256i percent = _mm256_set1_epi8('%');
+            const __m256i plus    = _mm256_set1_epi8(formEncoded ? '+' : '%');
+            std::size_t   i       = 0;
+
+            for (; (i + 32) <= n; i += 32) {
+                const __m256i in   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+                const auto    mask = static_cast<uint32_t>(
+                        _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(in, percent), _mm256_cmpeq_epi8(in, plus))));
+                if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+            }
+
+            return i;
+        }
+
+
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t allowedRunSSE41(const char* src, std::size_t n, const CharacterSet& set) noexcept
+        {
+            const __m128i bitmap = _mm_load_si128(reinterpret_cast<const __m128i*>(set.bitmap.data()));
+            std::size_t   i      = 0;
+
+            for (; (i + 16) <= n; i += 16) {
+                const auto mask = escapeMaskSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bitmap);
+                if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+            }
+
+            return i;
+        }
+
+
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t allowedRunAVX2(const char* src, std::size_t n, const CharacterSet& set) noexcept
+        {
+            const __m256i bitmap =
+                    _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(set.bitmap.data())));
+            std::size_t i = 0;
+
+            for (; (i + 32) <= n; i += 32) {
+                const auto mask = escapeMaskAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), bitmap);
+                if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+            }
+
+            return i;
+        }
+
+
+        /// @return Number of bytes examined; the caller finishes the tail
+        SIDDIQSOFT_TARGET("sse4.1")
+        static std::size_t countEscapedSSE41(const char* src, std::size_t n, const CharacterSet& set, std::size_t& count) noexcept
+        {
+            const __m128i bitmap = _mm_load_si128(reinterpret_cast<const __m128i*>(set.bitmap.data()));
+            std::size_t   i      = 0;
+
+            for (; (i + 16) <= n; i += 16) {
+                count += std::popcount(escapeMaskSSE41(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bitmap));
+            }
+
+            return i;
+        }
+
+
+        /// @return Number of bytes examined; the caller finishes the tail
+        SIDDIQSOFT_TARGET("avx2")
+        static std::size_t countEscapedAVX2(const char* src, std::size_t n, const CharacterSet& set, std::size_t& count) noexcept
+        {
+            const __m256i bitmap =
+                    _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(set.bitmap.data())));
+            std::size_t i = 0;
+
+            for (; (i + 32) <= n; i += 32) {
+                count += std::popcount(escapeMaskAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), bitmap));
+            }
+
+            return i;
+        }
+#endif
     };
 } // namespace siddiqsoft
 
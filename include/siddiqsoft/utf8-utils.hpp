@@ -0,0 +1,267 @@
+﻿/*
+    AzureCppUtils : Azure REST API Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+       list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+       this list of conditions and the following disclaimer in the documentation
+       and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+       contributors may be used to endorse or promote products derived from
+       this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, d_, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#pragma once
+
+#ifndef UTF8_UTILS_HPP
+#define UTF8_UTILS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+/// @brief SiddiqSoft
+namespace siddiqsoft
+{
+    /// @brief Minimal UTF-8 <-> wchar_t transcoding primitives for the fused wide-character paths.
+    ///        wchar_t is UTF-32 on Linux and macOS and UTF-16 on Windows; both are handled.
+    ///        Malformed input never fails; it is replaced by U+FFFD.
+    /// @remarks These are building blocks that work on buffers so the callers can transcode in fixed-size chunks without
+    ///          intermediate strings. `toUtf8` and `toWide` convert whole views where a string is required.
+    struct Utf8Utils
+    {
+        /// @brief Substituted for malformed input
+        static constexpr char32_t ReplacementCharacter = 0xfffd;
+
+
+        /// @brief Read the next code point from the wide source; combines UTF-16 surrogate pairs where wchar_t is 16-bit
+        /// @param src Advanced past the code point
+        static constexpr char32_t nextCodePoint(const wchar_t*& src, const wchar_t* end) noexcept
+        {
+            const auto unit = static_cast<char32_t>(static_cast<std::make_unsigned_t<wchar_t>>(*src++));
+
+            if constexpr (sizeof(wchar_t) == 2) {
+                if ((unit >= 0xd800) && (unit <= 0xdbff) && (src < end) && (*src >= 0xdc00) && (*src <= 0xdfff)) {
+                    return 0x10000 + ((unit - 0xd800) << 10) + (static_cast<char32_t>(*src++) - 0xdc00);
+                }
+            }
+
+            return ((unit > 0x10ffff) || ((unit >= 0xd800) && (unit <= 0xdfff))) ? ReplacementCharacter : unit;
+        }
+
+
+        /// @brief Number of bytes required to hold the code point as UTF-8 (1-4)
+        static constexpr std::size_t codePointLength(char32_t cp) noexcept
+        {
+            return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+        }
+
+
+        /// @brief Write the code point as UTF-8
+        /// @param dst Must have room for four bytes
+        /// @return Number of bytes written (1-4)
+        static constexpr std::size_t encodeCodePoint(char32_t cp, unsigned char* dst) noexcept
+        {
+            if (cp < 0x80) {
+                dst[0] = static_cast<unsigned char>(cp);
+                return 1;
+            }
+            if (cp < 0x800) {
+                dst[0] = static_cast<unsigned char>(0xc0 | (cp >> 6));
+                dst[1] = static_cast<unsigned char>(0x80 | (cp & 0x3f));
+                return 2;
+            }
+            if (cp < 0x10000) {
+                dst[0] = static_cast<unsigned char>(0xe0 | (cp >> 12));
+                dst[1] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3f));
+                dst[2] = static_cast<unsigned char>(0x80 | (cp & 0x3f));
+                return 3;
+            }
+
+            dst[0] = static_cast<unsigned char>(0xf0 | (cp >> 18));
+            dst[1] = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3f));
+            dst[2] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3f));
+            dst[3] = static_cast<unsigned char>(0x80 | (cp & 0x3f));
+            return 4;
+        }
+
+
+        /// @brief Number of bytes required to hold the wide source as UTF-8
+        static constexpr std::size_t encodedLength(std::wstring_view source) noexcept
+        {
+            std::size_t    length = 0;
+            const wchar_t* src    = source.data();
+            const wchar_t* end    = src + source.length();
+
+            if constexpr (sizeof(wchar_t) == 4) {
+                // Branch-free so it vectorizes; surrogates and out of range values are counted as U+FFFD (three bytes)
+                for (; src < end; src++) {
+                    const auto cp = static_cast<char32_t>(*src);
+                    length += 1 + (cp >= 0x80) + (cp >= 0x800) + ((cp >= 0x10000) && (cp <= 0x10ffff));
+                }
+            }
+            else {
+                while (src < end) {
+                    length += codePointLength(nextCodePoint(src, end));
+                }
+            }
+
+            return length;
+        }
+
+
+        /// @brief Decode the UTF-8 sequence at the start of `src`
+        /// @param n Bytes available
+        /// @param cp Receives the code point or `ReplacementCharacter` for a malformed sequence
+        /// @return Number of bytes consumed or 0 if the sequence is valid so far but needs more than `n` bytes
+        static constexpr std::size_t decodeCodePoint(const unsigned char* src, std::size_t n, char32_t& cp) noexcept
+        {
+            const unsigned char lead = src[0];
+            std::size_t         need = 0;
+            char32_t            min  = 0;
+
+            if (lead < 0x80) {
+                cp = lead;
+                return 1;
+            }
+            else if ((lead & 0xe0) == 0xc0) {
+                need = 2;
+                min  = 0x80;
+                cp   = lead & 0x1f;
+            }
+            else if ((lead & 0xf0) == 0xe0) {
+                need = 3;
+                min  = 0x800;
+                cp   = lead & 0x0f;
+            }
+            else if ((lead & 0xf8) == 0xf0) {
+                need = 4;
+                min  = 0x10000;
+                cp   = lead & 0x07;
+            }
+            else {
+                cp = ReplacementCharacter;
+                return 1;
+            }
+
+            for (std::size_t i = 1; i < need; i++) {
+                if (i >= n) return 0;
+                // A truncated sequence is replaced and decoding resumes at the offending byte
+                if ((src[i] & 0xc0) != 0x80) {
+                    cp = ReplacementCharacter;
+                    return i;
+                }
+                cp = (cp << 6) | (src[i] & 0x3f);
+            }
+
+            // Overlong forms, surrogates and values beyond Unicode are malformed
+            if ((cp < min) || (cp > 0x10ffff) || ((cp >= 0xd800) && (cp <= 0xdfff))) cp = ReplacementCharacter;
+            return need;
+        }
+
+
+        /// @brief Write the code point as wchar_t; a surrogate pair where wchar_t is 16-bit
+        /// @param dst Must have room for two wchar_t
+        /// @return Number of wchar_t written (1-2)
+        static constexpr std::size_t toWide(char32_t cp, wchar_t* dst) noexcept
+        {
+            if constexpr (sizeof(wchar_t) == 2) {
+                if (cp >= 0x10000) {
+                    dst[0] = static_cast<wchar_t>(0xd800 + ((cp - 0x10000) >> 10));
+                    dst[1] = static_cast<wchar_t>(0xdc00 + ((cp - 0x10000) & 0x3ff));
+                    return 2;
+                }
+            }
+
+            dst[0] = static_cast<wchar_t>(cp);
+            return 1;
+        }
+
+
+        /// @brief Transcode UTF-8 bytes to wchar_t
+        /// @param dst Must have room for `n` wchar_t (never more than one per byte)
+        /// @param final When false an incomplete sequence at the end is left unconsumed for the next call; when true it is
+        /// replaced with U+FFFD
+        /// @param consumed Receives the number of bytes consumed
+        /// @return Number of wchar_t written
+        static constexpr std::size_t
+        toWide(const unsigned char* src, std::size_t n, wchar_t* dst, bool final, std::size_t& consumed) noexcept
+        {
+            std::size_t i   = 0;
+            wchar_t*    out = dst;
+
+            while (i < n) {
+                if (src[i] < 0x80) {
+                    *out++ = static_cast<wchar_t>(src[i++]);
+                    continue;
+                }
+
+                char32_t cp   = 0;
+                auto     used = decodeCodePoint(src + i, n - i, cp);
+                if (used == 0) {
+                    if (!final) break;
+                    cp   = ReplacementCharacter;
+                    used = n - i;
+                }
+
+                out += toWide(cp, out);
+                i += used;
+            }
+
+            consumed = i;
+            return static_cast<std::size_t>(out - dst);
+        }
+
+
+        /// @brief Transcode the wide string to UTF-8
+        static std::string toUtf8(std::wstring_view source)
+        {
+            std::string    dest(encodedLength(source), 0);
+            auto           out = reinterpret_cast<unsigned char*>(dest.data());
+            const wchar_t* end = source.data() + source.length();
+
+            for (const wchar_t* src = source.data(); src < end;) out += encodeCodePoint(nextCodePoint(src, end), out);
+            return dest;
+        }
+
+
+        /// @brief Transcode the UTF-8 string to wchar_t
+        static std::wstring toWide(std::string_view source)
+        {
+            std::wstring dest(source.length(), 0);
+            std::size_t  consumed = 0;
+
+            dest.resize(
+                    toWide(reinterpret_cast<const unsigned char*>(source.data()), source.length(), dest.data(), true, consumed));
+            return dest;
+        }
+    };
+} // namespace siddiqsoft
+
+#endif // !UTF8_UTILS_HPP
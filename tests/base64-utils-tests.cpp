@@ -35,14 +35,22 @@
 
 #include "gtest/gtest.h"
 #include <chrono>
+#include <functional>
 #include <iostream>
 #include <ratio>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "siddiqsoft/conversion-utils.hpp"
 #include "../include/siddiqsoft/base64-utils.hpp"
 #include "../include/siddiqsoft/date-utils.hpp"
 #include "../include/siddiqsoft/encryption-utils.hpp"
 #include "../include/siddiqsoft/url-utils.hpp"
+#include "../include/siddiqsoft/base64-kernels.hpp"
+#include "../include/siddiqsoft/base64-stream.hpp"
 
 namespace siddiqsoft
 {
@@ -292,6 +300,80 @@ namespace siddiqsoft
         EXPECT_EQ(sample, roundTrip);
     }
 
+    TEST(Base64Utils, decode_preserves_trailing_zero_bytes)
+    {
+        // Binary keys may legitimately end with zero bytes; the length comes from the padding
+        std::string sample {"key\0\0", 5};
+        auto        roundTrip = Base64Utils::decode(Base64Utils::encode(sample));
+        EXPECT_EQ(sample, roundTrip);
+        EXPECT_EQ(5, roundTrip.length());
+
+        std::string zeros(6, '\0');
+        EXPECT_EQ(zeros, Base64Utils::decode(Base64Utils::encode(zeros)));
+    }
+
+    TEST(Base64Utils, decode_invalid_reports_offset)
+    {
+        std::size_t errorOffset {};
+
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG8*V29ybGQ="}, errorOffset).empty());
+        EXPECT_EQ(7, errorOffset);
+
+        // Padding is only valid at the end
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SG=sbG8gV29ybGQ="}, errorOffset).empty());
+        EXPECT_EQ(2, errorOffset);
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG8gV29ybG=Q"}, errorOffset).empty());
+        EXPECT_EQ(14, errorOffset);
+
+        // Truncated input; the incomplete group is reported
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG8gV29yb"}, errorOffset).empty());
+        EXPECT_EQ(12, errorOffset);
+
+        EXPECT_EQ("Hello World", Base64Utils::decode(std::string {"SGVsbG8gV29ybGQ="}, errorOffset));
+        EXPECT_EQ(Base64Kernels::npos, errorOffset);
+
+        std::wstring wideSource {L"SGVsbG8gV29ybGQ\u00e9"};
+        EXPECT_TRUE(Base64Utils::decode<wchar_t>(wideSource, errorOffset).empty());
+        EXPECT_EQ(15, errorOffset);
+    }
+
+    TEST(Base64Utils, urlsafe_known_value)
+    {
+        std::string sample {"\xfb\xff\xbf"};
+        EXPECT_EQ("+/+/", Base64Utils::encode(sample));
+        EXPECT_EQ("-_-_", Base64Utils::encode(sample, Base64Alphabet::UrlSafe));
+
+        EXPECT_EQ("-_8=", Base64Utils::encode(std::string {"\xfb\xff"}, Base64Alphabet::UrlSafe));
+        EXPECT_EQ("-_8", Base64Utils::encode(std::string {"\xfb\xff"}, Base64Alphabet::UrlSafe, false));
+        EXPECT_EQ("-w", Base64Utils::encode(std::string {"\xfb"}, Base64Alphabet::UrlSafe, false));
+        EXPECT_EQ(L"Pz8-", Base64Utils::encode<wchar_t>(L"?\?>", Base64Alphabet::UrlSafe));
+
+        EXPECT_EQ(sample, Base64Utils::decode(std::string {"-_-_"}, Base64Alphabet::UrlSafe));
+        EXPECT_EQ("\xfb\xff", Base64Utils::decode(std::string {"-_8="}, Base64Alphabet::UrlSafe));
+        EXPECT_EQ("\xfb\xff", Base64Utils::decode(std::string {"-_8"}, Base64Alphabet::UrlSafe));
+        EXPECT_EQ("\xfb", Base64Utils::decode(std::string {"-w"}, Base64Alphabet::UrlSafe));
+    }
+
+    TEST(Base64Utils, urlsafe_decode_rejects_other_alphabet)
+    {
+        std::size_t errorOffset {};
+
+        EXPECT_TRUE(Base64Utils::decode(std::string {"+/+/"}, errorOffset, Base64Alphabet::UrlSafe).empty());
+        EXPECT_EQ(0, errorOffset);
+        EXPECT_TRUE(Base64Utils::decode(std::string {"-_-_"}, errorOffset).empty());
+        EXPECT_EQ(0, errorOffset);
+
+        // Only base64url may omit the padding and a lone trailing character is never valid
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG8"}, errorOffset).empty());
+        EXPECT_EQ(4, errorOffset);
+        EXPECT_EQ("Hello", Base64Utils::decode(std::string {"SGVsbG8"}, errorOffset, Base64Alphabet::UrlSafe));
+        EXPECT_EQ(Base64Kernels::npos, errorOffset);
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG8gV"}, errorOffset, Base64Alphabet::UrlSafe).empty());
+        EXPECT_EQ(8, errorOffset);
+        EXPECT_TRUE(Base64Utils::decode(std::string {"SGVsbG="}, errorOffset, Base64Alphabet::UrlSafe).empty());
+        EXPECT_EQ(6, errorOffset);
+    }
+
     TEST(Base64Utils, decode_known_value)
     {
         // "SGVsbG8gV29ybGQ=" decodes to "Hello World"
@@ -408,4 +490,560 @@ namespace siddiqsoft
         auto         result = Base64Utils::urlEscape<wchar_t>(src);
         EXPECT_EQ(L"-_", result);
     }
+
+    // ---- Vector kernels (differential against OpenSSL) ----
+
+    TEST(Base64Utils, wide_matches_narrow_conversion)
+    {
+        // Mixed widths so code points straddle the internal chunk boundaries
+        std::wstring sample;
+        for (int i = 0; sample.length() < 5000; i++) {
+            sample += (i % 3 == 0) ? L"h\u00e9llo " : (i % 3 == 1) ? L"\u4e16\u754c" : L"\U0001F642!";
+        }
+
+        for (std::size_t length : {std::size_t {0}, std::size_t {1}, std::size_t {255}, std::size_t {257}, sample.length()}) {
+            auto source   = sample.substr(0, length);
+            auto expected = ConversionUtils::convert_to<char, wchar_t>(
+                    Base64Utils::encode<char>(ConversionUtils::convert_to<wchar_t, char>(source)));
+
+            auto encoded = Base64Utils::encode<wchar_t>(source);
+            ASSERT_EQ(expected, encoded) << "length " << length;
+            ASSERT_EQ(source, Base64Utils::decode<wchar_t>(encoded)) << "length " << length;
+
+            auto unpadded = Base64Utils::encode<wchar_t>(source, Base64Alphabet::UrlSafe, false);
+            ASSERT_EQ(source, Base64Utils::decode<wchar_t>(unpadded, Base64Alphabet::UrlSafe)) << "length " << length;
+        }
+    }
+
+    TEST(Base64Utils, wide_decode_reports_offset)
+    {
+        std::size_t  errorOffset {};
+        std::wstring encoded = Base64Utils::encode<wchar_t>(std::wstring(3000, L'x'));
+
+        // Past the first internal chunk
+        encoded[2100] = L'\u00e9';
+        EXPECT_TRUE(Base64Utils::decode<wchar_t>(encoded, errorOffset).empty());
+        EXPECT_EQ(2100, errorOffset);
+
+        // Decoded bytes which are not UTF-8 are replaced
+        EXPECT_EQ(L"a\ufffdb", Base64Utils::decode<wchar_t>(std::wstring {L"Yf9i"}));
+    }
+
+    TEST(Base64Utils, stream_encode_matches_oneshot)
+    {
+        std::mt19937                       rng {2021};
+        std::uniform_int_distribution<int> byteDist(0, 255);
+        std::uniform_int_distribution<int> chunkDist(0, 70);
+
+        for (auto alphabet : {Base64Alphabet::Standard, Base64Alphabet::UrlSafe}) {
+            for (bool padding : {true, false}) {
+                for (std::size_t length = 0; length < 600; length += 7) {
+                    std::string source(length, 0);
+                    std::ranges::generate(source, [&] { return static_cast<char>(byteDist(rng)); });
+
+                    std::string expected(Base64Kernels::encodedSize(length, padding), 0);
+                    Base64Kernels::encode(
+                            reinterpret_cast<const unsigned char*>(source.data()), length, expected.data(), alphabet, padding);
+
+                    // Random fragment sizes (including empty) exercise every carried length
+                    Base64Encoder encoder(alphabet, padding);
+                    std::string   encoded;
+                    auto          bytes = std::as_bytes(std::span {source});
+                    for (std::size_t offset = 0; offset < length;) {
+                        auto size = std::min<std::size_t>(chunkDist(rng), length - offset);
+                        encoder.update(bytes.subspan(offset, size), encoded);
+                        offset += size;
+                    }
+                    encoder.finish(encoded);
+
+                    ASSERT_EQ(expected, encoded) << "length " << length;
+                }
+            }
+        }
+    }
+
+    TEST(Base64Utils, stream_decode_matches_oneshot)
+    {
+        std::mt19937                       rng {2021};
+        std::uniform_int_distribution<int> byteDist(0, 255);
+        std::uniform_int_distribution<int> chunkDist(0, 90);
+
+        for (auto alphabet : {Base64Alphabet::Standard, Base64Alphabet::UrlSafe}) {
+            for (std::size_t length = 0; length < 600; length += 5) {
+                std::string source(length, 0);
+                std::ranges::generate(source, [&] { return static_cast<char>(byteDist(rng)); });
+
+                // base64url is also decoded unpadded
+                std::string encoded(Base64Kernels::encodedSize(length, alphabet == Base64Alphabet::Standard), 0);
+                Base64Kernels::encode(reinterpret_cast<const unsigned char*>(source.data()),
+                                      length,
+                                      encoded.data(),
+                                      alphabet,
+                                      alphabet == Base64Alphabet::Standard);
+
+                Base64Decoder          decoder(alphabet);
+                std::vector<std::byte> decoded;
+                for (std::size_t offset = 0; offset < encoded.length();) {
+                    auto size = std::min<std::size_t>(chunkDist(rng), encoded.length() - offset);
+                    ASSERT_TRUE(decoder.update(std::string_view(encoded).substr(offset, size), decoded));
+                    offset += size;
+                }
+                ASSERT_TRUE(decoder.finish(decoded));
+
+                ASSERT_EQ(length, decoded.size());
+                ASSERT_TRUE(std::ranges::equal(std::as_bytes(std::span {source}), decoded)) << "length " << length;
+            }
+        }
+    }
+
+    TEST(Base64Utils, stream_decode_reports_stream_offset)
+    {
+        std::string decoded;
+
+        // The invalid character is in the third fragment
+        Base64Decoder decoder;
+        EXPECT_TRUE(decoder.update("SGVsb", decoded));
+        EXPECT_TRUE(decoder.update("G8gV", decoded));
+        auto result = decoder.update("29*ybGQ=", decoded);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(11, result.errorOffset);
+        EXPECT_EQ("Hello ", decoded);
+        EXPECT_FALSE(decoder.finish(decoded));
+
+        // Padding in the middle of the stream
+        decoder.reset();
+        decoded.clear();
+        EXPECT_TRUE(decoder.update("SGVsbG8=", decoded));
+        result = decoder.update("SGVs", decoded);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(7, result.errorOffset);
+
+        // Truncated stream
+        decoder.reset();
+        decoded.clear();
+        EXPECT_TRUE(decoder.update("SGVsbG8gV29yb", decoded));
+        result = decoder.finish(decoded);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(12, result.errorOffset);
+
+        // The decoder may be reused after finish
+        decoder.reset();
+        decoded.clear();
+        EXPECT_TRUE(decoder.update("SGVsbG8gV29ybGQ=", decoded));
+        EXPECT_TRUE(decoder.finish(decoded));
+        EXPECT_EQ("Hello World", decoded);
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    static std::string opensslEncode(const std::string& source)
+    {
+        std::string dest(Base64Kernels::encodedSize(source.length()) + 1, 0);
+        auto        destSize = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(dest.data()),
+                                        reinterpret_cast<const unsigned char*>(source.data()),
+                                        static_cast<int>(source.length()));
+        dest.resize(destSize);
+        return dest;
+    }
+
+    static std::string randomBytes(std::size_t length, std::mt19937& rng)
+    {
+        std::string                        bytes(length, 0);
+        std::uniform_int_distribution<int> dist(0, 255);
+        std::ranges::generate(bytes, [&] { return static_cast<char>(dist(rng)); });
+        return bytes;
+    }
+
+    TEST(Base64Utils, kernels_encode_match_openssl)
+    {
+        std::mt19937 rng {2021};
+
+        for (auto kernel : {Base64Kernels::Kernel::Scalar,
+                            Base64Kernels::Kernel::SSE41,
+                            Base64Kernels::Kernel::AVX2,
+                            Base64Kernels::Kernel::AVX512VBMI})
+        {
+            if (!Base64Kernels::isSupported(kernel)) continue;
+
+            // Every length around the vector block sizes (12, 24, 48) and their load windows
+            for (std::size_t length = 0; length < 300; length++) {
+                auto        source = randomBytes(length, rng);
+                std::string dest(Base64Kernels::encodedSize(length), 0);
+                auto        written = Base64Kernels::encode(reinterpret_cast<const unsigned char*>(source.data()),
+                                                     source.length(),
+                                                     dest.data(),
+                                                     Base64Alphabet::Standard,
+                                                     true,
+                                                     kernel);
+
+                ASSERT_EQ(dest.length(), written);
+                ASSERT_EQ(opensslEncode(source), dest) << "kernel " << static_cast<int>(kernel) << " length " << length;
+            }
+        }
+    }
+
+    TEST(Base64Utils, kernels_decode_match_openssl)
+    {
+        std::mt19937 rng {2021};
+
+        for (auto kernel : {Base64Kernels::Kernel::Scalar,
+                            Base64Kernels::Kernel::SSE41,
+                            Base64Kernels::Kernel::AVX2,
+                            Base64Kernels::Kernel::AVX512VBMI})
+        {
+            if (!Base64Kernels::isSupported(kernel)) continue;
+
+            for (std::size_t length = 0; length < 300; length++) {
+                auto source  = randomBytes(length, rng);
+                auto encoded = opensslEncode(source);
+
+                // OpenSSL emits whole groups (zero filled); ours must match exactly up to the real length
+                std::string expected(((encoded.length() / 4) * 3) + 1, 0);
+                expected.resize(EVP_DecodeBlock(reinterpret_cast<unsigned char*>(expected.data()),
+                                                reinterpret_cast<const unsigned char*>(encoded.data()),
+                                                static_cast<int>(encoded.length())));
+                expected.resize(length);
+
+                std::string dest(Base64Kernels::decodedSize(encoded.data(), encoded.length()), 0);
+                ASSERT_EQ(length, dest.length());
+
+                auto result = Base64Kernels::decode(encoded.data(),
+                                                    encoded.length(),
+                                                    reinterpret_cast<unsigned char*>(dest.data()),
+                                                    Base64Alphabet::Standard,
+                                                    kernel);
+                ASSERT_TRUE(result) << "kernel " << static_cast<int>(kernel) << " length " << length;
+                ASSERT_EQ(length, result.written);
+                ASSERT_EQ(expected, dest) << "kernel " << static_cast<int>(kernel) << " length " << length;
+            }
+        }
+    }
+
+    TEST(Base64Utils, kernels_decode_report_error_offset)
+    {
+        std::mt19937 rng {2021};
+
+        for (auto kernel : {Base64Kernels::Kernel::Scalar,
+                            Base64Kernels::Kernel::SSE41,
+                            Base64Kernels::Kernel::AVX2,
+                            Base64Kernels::Kernel::AVX512VBMI})
+        {
+            if (!Base64Kernels::isSupported(kernel)) continue;
+
+            auto encoded = opensslEncode(randomBytes(240, rng));
+            for (std::size_t offset = 0; offset < encoded.length() - 4; offset++) {
+                for (char invalid : {'*', '=', '\n', '\x80', '\0'}) {
+                    auto        corrupted = encoded;
+                    std::string dest(Base64Kernels::decodedSize(corrupted.data(), corrupted.length()), 0);
+
+                    corrupted[offset] = invalid;
+                    auto result       = Base64Kernels::decode(corrupted.data(),
+                                                        corrupted.length(),
+                                                        reinterpret_cast<unsigned char*>(dest.data()),
+                                                        Base64Alphabet::Standard,
+                                                        kernel);
+                    ASSERT_FALSE(result);
+                    ASSERT_EQ(offset, result.errorOffset) << "kernel " << static_cast<int>(kernel);
+                }
+            }
+        }
+    }
+
+    TEST(Base64Utils, kernels_urlsafe_match_urlescape)
+    {
+        std::mt19937 rng {2021};
+
+        for (auto kernel : {Base64Kernels::Kernel::Scalar,
+                            Base64Kernels::Kernel::SSE41,
+                            Base64Kernels::Kernel::AVX2,
+                            Base64Kernels::Kernel::AVX512VBMI})
+        {
+            if (!Base64Kernels::isSupported(kernel)) continue;
+
+            for (std::size_t length = 0; length < 300; length++) {
+                auto source   = randomBytes(length, rng);
+                auto expected = Base64Utils::urlEscape(opensslEncode(source));
+
+                for (bool padding : {true, false}) {
+                    std::string dest(Base64Kernels::encodedSize(length, padding), 0);
+                    auto        written = Base64Kernels::encode(reinterpret_cast<const unsigned char*>(source.data()),
+                                                         source.length(),
+                                                         dest.data(),
+                                                         Base64Alphabet::UrlSafe,
+                                                         padding,
+                                                         kernel);
+                    ASSERT_EQ(dest.length(), written);
+                    // urlEscape drops the padding
+                    ASSERT_EQ(expected, padding ? Base64Utils::urlEscape(dest) : dest)
+                            << "kernel " << static_cast<int>(kernel) << " length " << length;
+
+                    std::string decoded(Base64Kernels::decodedSize(dest.data(), dest.length()), 0);
+                    ASSERT_EQ(length, decoded.length());
+
+                    auto result = Base64Kernels::decode(dest.data(),
+                                                        dest.length(),
+                                                        reinterpret_cast<unsigned char*>(decoded.data()),
+                                                        Base64Alphabet::UrlSafe,
+                                                        kernel);
+                    ASSERT_TRUE(result) << "kernel " << static_cast<int>(kernel) << " length " << length;
+                    ASSERT_EQ(source, decoded) << "kernel " << static_cast<int>(kernel) << " length " << length;
+                }
+            }
+        }
+    }
+
+    TEST(Base64Utils, encode_large_match_openssl)
+    {
+        std::mt19937 rng {1969};
+        auto         source = randomBytes((4 * 1024 * 1024) + 7, rng);
+
+        EXPECT_EQ(opensslEncode(source), Base64Utils::encode(source));
+    }
+
+    TEST(Base64Utils, decode_large_match_openssl)
+    {
+        std::mt19937 rng {1969};
+        auto         source = randomBytes((4 * 1024 * 1024) + 7, rng);
+
+        EXPECT_EQ(source, Base64Utils::decode(opensslEncode(source)));
+    }
+
+    TEST(Base64Utils, sizes_are_constexpr)
+    {
+        static_assert(Base64Utils::encodedSize(0) == 0);
+        static_assert(Base64Utils::encodedSize(11) == 16);
+        static_assert(Base64Utils::encodedSize(11, false) == 15);
+        static_assert(Base64Utils::decodedSize("SGVsbG8gV29ybGQ=") == 11);
+        static_assert(Base64Utils::decodedSize("SGVsbG8gV29ybGQ") == 11);
+        EXPECT_EQ(16, Base64Utils::encodedSize(12));
+    }
+
+    TEST(Base64Utils, encodeInto_span)
+    {
+        std::string sample {"Hello World"};
+        char        buffer[32] {};
+
+        auto written = Base64Utils::encodeInto(std::as_bytes(std::span {sample}), std::span {buffer});
+        EXPECT_EQ(16, written);
+        EXPECT_EQ("SGVsbG8gV29ybGQ=", std::string_view(buffer, written));
+
+        // Exactly sized is fine; one short is not
+        EXPECT_EQ(15,
+                  Base64Utils::encodeInto(
+                          std::as_bytes(std::span {sample}), std::span {buffer, 15}, Base64Alphabet::UrlSafe, false));
+        EXPECT_THROW(Base64Utils::encodeInto(std::as_bytes(std::span {sample}), std::span {buffer, 15}), std::invalid_argument);
+    }
+
+    TEST(Base64Utils, encodeInto_appends)
+    {
+        std::string sample {"Hello World"};
+        std::string body {"data:"};
+
+        EXPECT_EQ(16, Base64Utils::encodeInto(std::as_bytes(std::span {sample}), body));
+        EXPECT_EQ("data:SGVsbG8gV29ybGQ=", body);
+
+        std::vector<char> chars;
+        Base64Utils::encodeInto(std::as_bytes(std::span {sample}), chars, Base64Alphabet::UrlSafe, false);
+        EXPECT_EQ("SGVsbG8gV29ybGQ", std::string(chars.begin(), chars.end()));
+    }
+
+    TEST(Base64Utils, decodeInto_span)
+    {
+        std::byte buffer[16] {};
+
+        auto result = Base64Utils::decodeInto("SGVsbG8gV29ybGQ=", std::span {buffer});
+        ASSERT_TRUE(result);
+        EXPECT_EQ(11, result.written);
+        EXPECT_EQ("Hello World", std::string(reinterpret_cast<const char*>(buffer), result.written));
+
+        result = Base64Utils::decodeInto("SGVsbG8*V29ybGQ=", std::span {buffer});
+        EXPECT_FALSE(result);
+        EXPECT_EQ(7, result.errorOffset);
+
+        EXPECT_THROW(Base64Utils::decodeInto("SGVsbG8gV29ybGQ=", std::span {buffer, 10}), std::invalid_argument);
+    }
+
+    TEST(Base64Utils, decodeInto_appends)
+    {
+        std::vector<std::byte> bytes {std::byte {0x01}};
+
+        auto result = Base64Utils::decodeInto("SGVsbG8", bytes, Base64Alphabet::UrlSafe);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(5, result.written);
+        ASSERT_EQ(6, bytes.size());
+        EXPECT_EQ(std::byte {'H'}, bytes[1]);
+
+        // Failure leaves the buffer untouched
+        std::string text {"prefix"};
+        EXPECT_FALSE(Base64Utils::decodeInto("SGVs*G8=", text));
+        EXPECT_EQ("prefix", text);
+    }
+
+    TEST(Base64Utils, constexpr_encode)
+    {
+        static constexpr auto encoded = Base64Utils::encodeFixed("Hello World");
+        static_assert(std::string_view(encoded.data(), encoded.size()) == "SGVsbG8gV29ybGQ=");
+
+        static constexpr auto jwtHeader = Base64Utils::encodeFixed<Base64Alphabet::UrlSafe, false>(R"({"alg":"HS256","typ":"JWT"})");
+        static_assert(std::string_view(jwtHeader.data(), jwtHeader.size()) == "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9");
+
+        static constexpr std::array<std::byte, 3> bytes {std::byte {0xfb}, std::byte {0xff}, std::byte {0xbf}};
+        static_assert(std::string_view(Base64Utils::encodeFixed(bytes).data(), 4) == "+/+/");
+        static_assert(std::string_view(Base64Utils::encodeFixed<Base64Alphabet::UrlSafe>(bytes).data(), 4) == "-_-_");
+
+        static_assert([] {
+            std::array<char, Base64Utils::encodedSize(5, false)> dest {};
+            return (Base64Utils::encodeInto("\xfb\xffHel", dest, Base64Alphabet::UrlSafe, false) == 7) &&
+                   (std::string_view(dest.data(), dest.size()) == "-_9IZWw");
+        }());
+
+        // Same result as the runtime (vector) path
+        EXPECT_EQ(Base64Utils::encode(std::string {R"({"alg":"HS256","typ":"JWT"})"}, Base64Alphabet::UrlSafe, false),
+                  std::string(jwtHeader.data(), jwtHeader.size()));
+    }
+
+    TEST(Base64Utils, constexpr_decode)
+    {
+        static constexpr auto key = [] {
+            std::array<char, Base64Utils::decodedSize("SGVsbG8gV29ybGQ=")> dest {};
+            Base64Utils::decodeInto("SGVsbG8gV29ybGQ=", dest);
+            return dest;
+        }();
+        static_assert(std::string_view(key.data(), key.size()) == "Hello World");
+
+        static_assert([] {
+            std::array<std::byte, Base64Utils::decodedSize("-_-_")> dest {};
+            auto result = Base64Utils::decodeInto("-_-_", dest, Base64Alphabet::UrlSafe);
+            return result && (dest[0] == std::byte {0xfb}) && (dest[1] == std::byte {0xff}) && (dest[2] == std::byte {0xbf});
+        }());
+
+        // Invalid input reports the offset during constant evaluation as well
+        static_assert([] {
+            std::array<char, 16> dest {};
+            return Base64Utils::decodeInto("SGVsbG8*V29ybGQ=", dest).errorOffset;
+        }() == 7);
+
+        // Same result as the runtime (vector) path
+        std::string source(200, 'x');
+        auto        encoded = Base64Utils::encode(source);
+        std::string dest(Base64Utils::decodedSize(encoded), 0);
+        EXPECT_TRUE(Base64Utils::decodeInto(encoded, std::span<char> {dest}));
+        EXPECT_EQ(source, dest);
+    }
+
+    TEST(Base64Utils, encodeBatch_matches_encode)
+    {
+        std::mt19937             rng {2021};
+        std::vector<std::string> messages;
+        for (std::size_t length : {0, 1, 2, 3, 200, 511, 1024, 2047}) messages.push_back(randomBytes(length, rng));
+
+        // The arena keeps its existing content; offsets are absolute
+        std::string arena {"batch:"};
+        auto        items = Base64Utils::encodeBatch(messages, arena);
+
+        ASSERT_EQ(messages.size(), items.size());
+        EXPECT_EQ(6, items.front().offset);
+        EXPECT_EQ(arena.length(), items.back().offset + items.back().length);
+        for (std::size_t i = 0; i < messages.size(); i++) {
+            EXPECT_EQ(Base64Utils::encode(messages[i]), arena.substr(items[i].offset, items[i].length));
+        }
+
+        // Spans into a byte arena, base64url without padding
+        std::vector<std::span<const std::byte>> spans;
+        for (const auto& message : messages) spans.push_back(std::as_bytes(std::span {message}));
+
+        std::vector<char> bytes;
+        items = Base64Utils::encodeBatch(spans, bytes, Base64Alphabet::UrlSafe, false);
+        for (std::size_t i = 0; i < messages.size(); i++) {
+            EXPECT_EQ(Base64Utils::encode(messages[i], Base64Alphabet::UrlSafe, false),
+                      std::string(bytes.data() + items[i].offset, items[i].length));
+        }
+    }
+
+    TEST(Base64Utils, encodeParallel_matches_encode)
+    {
+        std::mt19937 rng {1969};
+        auto         source = randomBytes((2 * Base64Utils::ParallelThreshold) + 5, rng);
+
+        EXPECT_EQ(Base64Utils::encode(source), Base64Utils::encodeParallel(source));
+        EXPECT_EQ(Base64Utils::encode(source, Base64Alphabet::UrlSafe, false),
+                  Base64Utils::encodeParallel(source, Base64Alphabet::UrlSafe, false));
+
+        // Caller supplied executors; one inline and one on its own threads
+        std::vector<std::jthread> pool;
+        EXPECT_EQ(Base64Utils::encode(source),
+                  Base64Utils::encodeParallel(source, Base64Alphabet::Standard, true, [](auto task) { task(); }));
+        EXPECT_EQ(Base64Utils::encode(source),
+                  Base64Utils::encodeParallel(
+                          source, Base64Alphabet::Standard, true, [&](auto task) { pool.emplace_back(std::move(task)); }));
+
+        // Small inputs stay on the single-threaded path
+        EXPECT_EQ("SGVsbG8gV29ybGQ=", Base64Utils::encodeParallel("Hello World"));
+    }
+
+    TEST(Base64Utils, encodeParallel_executor_throws)
+    {
+        std::mt19937 rng {1969};
+        auto         source = randomBytes((2 * Base64Utils::ParallelThreshold) + 5, rng);
+
+        // The first task runs on its own thread and the executor refuses the rest; the queued task must finish before the
+        // exception leaves encodeParallel
+        std::vector<std::jthread> pool;
+        auto                      executor = [&](std::function<void()> task) {
+            if (!pool.empty()) throw std::runtime_error("executor is full");
+            pool.emplace_back(std::move(task));
+        };
+
+        // Only one worker (no executor calls) on machines with fewer than three threads
+        if (std::thread::hardware_concurrency() > 2) {
+            EXPECT_THROW(Base64Utils::encodeParallel(source, Base64Alphabet::Standard, true, executor), std::runtime_error);
+        }
+        else {
+            EXPECT_EQ(Base64Utils::encode(source), Base64Utils::encodeParallel(source, Base64Alphabet::Standard, true, executor));
+        }
+    }
+
+    TEST(Base64Utils, decodeParallel_matches_decode)
+    {
+        std::mt19937 rng {1969};
+        auto         source = randomBytes((2 * Base64Utils::ParallelThreshold) + 4, rng);
+        std::size_t  errorOffset {};
+
+        auto encoded = Base64Utils::encode(source);
+        EXPECT_EQ(source, Base64Utils::decodeParallel(encoded, errorOffset));
+        EXPECT_EQ(Base64Kernels::npos, errorOffset);
+
+        auto unpadded = Base64Utils::encode(source, Base64Alphabet::UrlSafe, false);
+        EXPECT_EQ(source, Base64Utils::decodeParallel(unpadded, errorOffset, Base64Alphabet::UrlSafe));
+
+        // Two chunks fail; the lowest offset wins regardless of which finishes first
+        auto corrupted                                = encoded;
+        corrupted[encoded.length() / 2]               = '*';
+        corrupted[Base64Utils::ParallelChunkSize + 1] = '*';
+        EXPECT_TRUE(Base64Utils::decodeParallel(corrupted, errorOffset).empty());
+        EXPECT_EQ(Base64Utils::ParallelChunkSize + 1, errorOffset);
+
+        // The final group is decoded separately
+        corrupted                       = encoded;
+        corrupted[encoded.length() - 2] = '=';
+        EXPECT_TRUE(Base64Utils::decodeParallel(corrupted, errorOffset).empty());
+        EXPECT_EQ(encoded.length() - 2, errorOffset);
+    }
+
+    TEST(Base64Utils, string_view_inputs)
+    {
+        std::string_view request {"Authorization: SGVsbG8gV29ybGQ="};
+        auto             value = request.substr(15);
+
+        EXPECT_EQ("Hello World", Base64Utils::decode(value));
+        EXPECT_EQ("Hello World", Base64Utils::decode("SGVsbG8gV29ybGQ", Base64Alphabet::UrlSafe));
+        EXPECT_EQ("SGVsbG8gV29ybGQ=", Base64Utils::encode("Hello World"));
+        EXPECT_EQ(L"SGVsbG8gV29ybGQ=", Base64Utils::encode<wchar_t>(L"Hello World"));
+        EXPECT_EQ(L"Hello World", Base64Utils::decode<wchar_t>(std::wstring_view {L"SGVsbG8gV29ybGQ="}));
+        EXPECT_EQ("SGVsbG8", Base64Utils::urlEscape("SGVsbG8="));
+
+        const std::byte bytes[] {std::byte {0xfb}, std::byte {0xff}};
+        EXPECT_EQ("+/8=", Base64Utils::encode(std::span(bytes)));
+        EXPECT_EQ("-_8", Base64Utils::encode(std::span(bytes), Base64Alphabet::UrlSafe, false));
+    }
+#endif
 } // namespace siddiqsoft
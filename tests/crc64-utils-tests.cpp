@@ -0,0 +1,112 @@
+﻿/*
+    AzureCppUtils : Azure Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../include/siddiqsoft/crc64-utils.hpp"
+
+namespace siddiqsoft
+{
+    /// @brief Bit at a time reference
+    static std::uint64_t crc64Reference(std::string_view data)
+    {
+        std::uint64_t reg = ~std::uint64_t {0};
+
+        for (unsigned char ch : data) {
+            reg ^= ch;
+            for (int bit = 0; bit < 8; bit++) reg = (reg & 1) ? ((reg >> 1) ^ Crc64Utils::Polynomial) : (reg >> 1);
+        }
+        return ~reg;
+    }
+
+    TEST(Crc64Utils, check_value)
+    {
+        EXPECT_EQ(0, Crc64Utils::compute(std::string_view {}));
+        EXPECT_EQ(0xae8b14860a799888, Crc64Utils::compute("123456789"));
+        EXPECT_EQ(0xae8b14860a799888, Crc64Utils::update(Crc64Utils::compute("1234"), std::as_bytes(std::span("56789", 5))));
+        EXPECT_EQ("iJh5CoYUi64=", Crc64Utils::encodeHeader(0xae8b14860a799888));
+    }
+
+    TEST(Crc64Utils, kernels_match_reference)
+    {
+        std::string source(2200, 0);
+        for (std::size_t i = 0; i < source.size(); i++) source[i] = static_cast<char>((i * 131) ^ (i >> 3));
+
+        for (auto kernel : {Crc64Utils::Kernel::Scalar, Crc64Utils::Kernel::PCLMUL, Crc64Utils::Kernel::VPCLMUL}) {
+            if (!Crc64Utils::isSupported(kernel)) continue;
+
+            // Lengths either side of each fold width with unaligned starts and a continued CRC
+            for (std::size_t length = 0; length <= 1100; length += (length < 300) ? 1 : 13) {
+                for (std::size_t offset : {0, 1, 7}) {
+                    const auto data     = std::string_view {source}.substr(offset, length);
+                    const auto expected = crc64Reference(data);
+                    const auto src      = reinterpret_cast<const unsigned char*>(data.data());
+
+                    ASSERT_EQ(expected, Crc64Utils::update(0, src, data.length(), kernel))
+                            << "kernel " << static_cast<int>(kernel) << " length " << length;
+                    ASSERT_EQ(expected,
+                              Crc64Utils::update(Crc64Utils::update(0, src, length / 3, kernel),
+                                                 src + (length / 3),
+                                                 length - (length / 3),
+                                                 kernel));
+                }
+            }
+        }
+    }
+
+    TEST(Crc64Utils, combine)
+    {
+        std::string source(5000, 0);
+        for (std::size_t i = 0; i < source.size(); i++) source[i] = static_cast<char>((i * 29) + 3);
+
+        const auto whole = Crc64Utils::compute(source);
+        for (std::size_t split : {0, 1, 8, 100, 2500, 4999, 5000}) {
+            const auto first  = Crc64Utils::compute(std::string_view {source}.substr(0, split));
+            const auto second = Crc64Utils::compute(std::string_view {source}.substr(split));
+            EXPECT_EQ(whole, Crc64Utils::combine(first, second, source.size() - split)) << "split " << split;
+        }
+
+        // Usable at compile time
+        static_assert(Crc64Utils::combine(0, 0, 0) == 0);
+    }
+} // namespace siddiqsoft
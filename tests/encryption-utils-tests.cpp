@@ -37,6 +37,13 @@
 #include <chrono>
 #include <iostream>
 #include <ratio>
+#include <span>
+#include <string_view>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <format>
 
 #include "siddiqsoft/conversion-utils.hpp"
 #include "../include/siddiqsoft/base64-utils.hpp"
@@ -307,6 +314,14 @@ namespace siddiqsoft
         // If available: "a448017aaf21d8525fc10ae87aa6729d", otherwise empty
         EXPECT_TRUE(result.empty() || result == "a448017aaf21d8525fc10ae87aa6729d");
     }
+
+    TEST(EncryptionUtils, calcDigest_other_MD5_names)
+    {
+        // Other MD5/MD4-prefixed names are fetched by name; MD5-SHA1 is the MD5 followed by the SHA-1
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72a9993e364706816aba3e25717850c26c9cd0d89d",
+                  EncryptionUtils::calcDigest("MD5-SHA1", "abc"));
+        EXPECT_THROW(EncryptionUtils::calcDigest("MD5-UNKNOWN", "abc"), std::runtime_error);
+    }
 #endif
 
     TEST(EncryptionUtils, HMAC_empty_message)
@@ -593,4 +608,468 @@ namespace siddiqsoft
         EXPECT_NE(std::wstring::npos, secondDot);
         EXPECT_EQ(std::wstring::npos, jwt.find(L'.', secondDot + 1));
     }
+
+    // ---- string_view and byte span inputs ----
+
+    TEST(EncryptionUtils, string_view_inputs)
+    {
+        std::string_view connection {"key=bp7ym3X;message=hello"};
+        auto             key     = connection.substr(4, 7);
+        auto             message = connection.substr(20);
+
+        EXPECT_EQ(EncryptionUtils::HMAC(std::string {"hello"}, std::string {"bp7ym3X"}), EncryptionUtils::HMAC(message, key));
+        EXPECT_EQ(EncryptionUtils::HMAC(std::string {"hello"}, std::string {"bp7ym3X"}),
+                  EncryptionUtils::HMAC(std::as_bytes(std::span(message)), std::as_bytes(std::span(key))));
+        EXPECT_EQ("bp7ym3X//Ft6uuUn1Y/a2y/kLnIZARl2kXNDBl9Y7Uo=", Base64Utils::encode(EncryptionUtils::HMAC("message", "key")));
+
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::MD5("abc"));
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::MD5<wchar_t>(L"abc"));
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::MD5(std::as_bytes(std::span(std::string_view {"abc"}))));
+    }
+
+    TEST(EncryptionUtils, CosmosToken_string_view)
+    {
+        auto decodedKey = Base64Utils::decode(
+                std::string_view {"dsZQi3KtZmCv1ljt3VNWNm7sQUF1y5rJfC6kv5JiwvW0EndXdDku/dkKBp8/ufDToSxLzR4y+O/0H/t4bQtVNw=="});
+        std::string_view request {"GET dbs/ToDoList"};
+
+        auto auth = EncryptionUtils::CosmosToken(
+                decodedKey, request.substr(0, 3), "dbs", request.substr(4), std::string_view {"Thu, 27 Apr 2017 00:51:12 GMT"});
+        EXPECT_EQ("type%3dmaster%26ver%3d1.0%26sig%3dc09PEVJrgp2uQRkr934kFbTqhByc7TVr3OHyqlu%2bc%2bc%3d", auth);
+
+        auto wauth = EncryptionUtils::CosmosToken<wchar_t>(
+                decodedKey, std::wstring_view {L"GET"}, L"dbs", L"dbs/ToDoList", L"Thu, 27 Apr 2017 00:51:12 GMT");
+        EXPECT_EQ(L"type%3dmaster%26ver%3d1.0%26sig%3dc09PEVJrgp2uQRkr934kFbTqhByc7TVr3OHyqlu%2bc%2bc%3d", wauth);
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    // ---- HmacSha256Signer ----
+
+    TEST(HmacSha256Signer, matches_HMAC)
+    {
+        HmacSha256Signer signer {std::string_view {"key"}};
+
+        EXPECT_EQ("bp7ym3X//Ft6uuUn1Y/a2y/kLnIZARl2kXNDBl9Y7Uo=", Base64Utils::encode(signer.sign("message")));
+
+        // The signer is reused; each signature starts from the absorbed key
+        auto decodedKey = Base64Utils::decode(
+                std::string {"dsZQi3KtZmCv1ljt3VNWNm7sQUF1y5rJfC6kv5JiwvW0EndXdDku/dkKBp8/ufDToSxLzR4y+O/0H/t4bQtVNw=="});
+        HmacSha256Signer cosmos {decodedKey};
+        for (const auto& message : {std::string {"get\ndbs\n\n"}, std::string(200, 'x'), std::string {"a"}}) {
+            EXPECT_EQ(EncryptionUtils::HMAC(message, decodedKey), cosmos.sign(message));
+        }
+
+        std::array<std::byte, HmacSha256Signer::DigestSize> dest {};
+        cosmos.sign(std::as_bytes(std::span(std::string_view {"a"})), dest);
+        EXPECT_EQ(EncryptionUtils::HMAC(std::string {"a"}, decodedKey),
+                  std::string(reinterpret_cast<const char*>(dest.data()), dest.size()));
+    }
+
+    TEST(HmacSha256Signer, concurrent_sign)
+    {
+        const HmacSha256Signer   signer {std::string_view {"shared-key"}};
+        const auto               expected = EncryptionUtils::HMAC(std::string {"payload"}, std::string {"shared-key"});
+        std::atomic<int>         mismatches {0};
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t < 4; t++) {
+            workers.emplace_back([&] {
+                for (int i = 0; i < 500; i++) {
+                    if (signer.sign("payload") != expected) mismatches++;
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        EXPECT_EQ(0, mismatches.load());
+    }
+
+    TEST(EncryptionUtils, calcDigest_DigestType)
+    {
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::calcDigest(DigestType::MD5, "abc"));
+        EXPECT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", EncryptionUtils::calcDigest(DigestType::SHA1, "abc"));
+        EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+                  EncryptionUtils::calcDigest(DigestType::SHA256, "abc"));
+        EXPECT_EQ(128, EncryptionUtils::calcDigest(DigestType::SHA512, "abc").length());
+        EXPECT_TRUE(EncryptionUtils::calcDigest(DigestType::SHA256, "").empty());
+
+        // MD4 needs the legacy provider
+        auto md4 = EncryptionUtils::calcDigest(DigestType::MD4, "abc");
+        EXPECT_TRUE(md4.empty() || md4 == "a448017aaf21d8525fc10ae87aa6729d");
+    }
+
+    TEST(EncryptionUtils, calcDigest_formats)
+    {
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::calcDigest(DigestType::MD5, "abc", DigestFormat::Hex));
+        EXPECT_EQ("900150983CD24FB0D6963F7D28E17F72", EncryptionUtils::calcDigest(DigestType::MD5, "abc", DigestFormat::UpperHex));
+        EXPECT_EQ(HexUtils::decode("900150983cd24fb0d6963f7d28e17f72"),
+                  EncryptionUtils::calcDigest(DigestType::MD5, "abc", DigestFormat::Raw));
+        // Content-MD5 directly
+        EXPECT_EQ("kAFQmDzST7DWlj99KOF/cg==", EncryptionUtils::calcDigest(DigestType::MD5, "abc", DigestFormat::Base64));
+        EXPECT_EQ("kAFQmDzST7DWlj99KOF/cg==", EncryptionUtils::MD5("abc", DigestFormat::Base64));
+        EXPECT_EQ("kAFQmDzST7DWlj99KOF/cg==", EncryptionUtils::MD5(std::wstring {L"abc"}, DigestFormat::Base64));
+        EXPECT_EQ("kAFQmDzST7DWlj99KOF/cg==",
+                  EncryptionUtils::MD5(std::as_bytes(std::span(std::string_view {"abc"})), DigestFormat::Base64));
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", EncryptionUtils::MD5(std::string {"abc"}));
+
+        Digest sha256 {DigestType::SHA256};
+        EXPECT_EQ("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD",
+                  sha256.update("abc").final(DigestFormat::UpperHex));
+    }
+
+    TEST(EncryptionUtils, OpenSslAlgorithms_cached)
+    {
+        // Fetched once and shared
+        EXPECT_NE(nullptr, OpenSslAlgorithms::digest(DigestType::SHA256));
+        EXPECT_EQ(OpenSslAlgorithms::digest(DigestType::SHA256), OpenSslAlgorithms::digest(DigestType::SHA256));
+        EXPECT_NE(nullptr, OpenSslAlgorithms::hmac());
+        EXPECT_EQ(OpenSslAlgorithms::hmac(), OpenSslAlgorithms::hmac());
+        EXPECT_NE(nullptr, OpenSslAlgorithms::hmacSha256());
+        EXPECT_EQ(OpenSslAlgorithms::hmacSha256(), OpenSslAlgorithms::hmacSha256());
+        EXPECT_EQ(OpenSslAlgorithms::digest("MD5-SHA1"), OpenSslAlgorithms::digest("MD5-SHA1"));
+    }
+
+    TEST(HmacSha256Signer, empty_key_throws)
+    {
+        EXPECT_THROW(HmacSha256Signer {std::string_view {}}, std::invalid_argument);
+    }
+
+    // ---- Sha256Kernels and HMACBatch ----
+
+    TEST(Sha256Kernels, kernels_match_scalar)
+    {
+        std::array<unsigned char, Sha256Kernels::DigestSize> digest {};
+        Sha256Kernels::toBytes(Sha256Kernels::hash(Sha256Kernels::InitialState, reinterpret_cast<const unsigned char*>("abc"), 3),
+                               digest.data());
+        EXPECT_EQ("ungWv48Bz+pBQUDeXa4iI7ADYaOWF3qctBD/YfIAFa0=",
+                  Base64Utils::encode(std::string(reinterpret_cast<const char*>(digest.data()), digest.size())));
+
+        // Lengths either side of the padding boundaries (55/56 and 64 bytes) in lanes that finish at different blocks
+        std::string                  source(300, 0);
+        std::vector<Sha256Kernels::Job> jobs;
+        for (std::size_t i = 0; i < source.size(); i++) source[i] = static_cast<char>(i * 7);
+        for (std::size_t length = 0; length <= 200; length++) {
+            jobs.push_back({&Sha256Kernels::InitialState,
+                            reinterpret_cast<const unsigned char*>(source.data()) + (length % 13),
+                            length,
+                            0});
+        }
+
+        std::vector<Sha256Kernels::State> expected(jobs.size());
+        Sha256Kernels::hashBatch(jobs, expected, Sha256Kernels::Kernel::Scalar);
+
+        for (auto kernel : {Sha256Kernels::Kernel::SHA, Sha256Kernels::Kernel::AVX2, Sha256Kernels::Kernel::AVX512}) {
+            if (!Sha256Kernels::isSupported(kernel)) continue;
+
+            std::vector<Sha256Kernels::State> results(jobs.size());
+            Sha256Kernels::hashBatch(jobs, results, kernel);
+            EXPECT_EQ(expected, results) << "kernel " << static_cast<int>(kernel);
+        }
+    }
+
+    TEST(Sha256Kernels, test_vectors)
+    {
+        // FIPS 180-2 examples checked with every single-buffer kernel and against OpenSSL
+        const std::array<std::pair<std::string_view, std::string_view>, 3> vectors {
+                {{"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+                 {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+                 {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"}}};
+
+        for (auto kernel : {Sha256Kernels::Kernel::Scalar, Sha256Kernels::Kernel::SHA}) {
+            if (!Sha256Kernels::isSupported(kernel)) continue;
+
+            for (const auto& [message, expected] : vectors) {
+                std::array<unsigned char, Sha256Kernels::DigestSize> digest {};
+                std::string                                          hex;
+
+                Sha256Kernels::toBytes(Sha256Kernels::hash(Sha256Kernels::InitialState,
+                                                           reinterpret_cast<const unsigned char*>(message.data()),
+                                                           message.length(),
+                                                           0,
+                                                           kernel),
+                                       digest.data());
+                for (auto ch : digest) hex += std::format("{:02x}", ch);
+                EXPECT_EQ(expected, hex) << "kernel " << static_cast<int>(kernel);
+                if (!message.empty()) {
+                    EXPECT_EQ(EncryptionUtils::calcDigest(DigestType::SHA256, message), hex);
+                }
+            }
+        }
+    }
+
+    TEST(NativeHmacSha256Signer, matches_OpenSSL)
+    {
+        // RFC 4231 test case 2
+        NativeHmacSha256Signer jefe {std::string_view {"Jefe"}};
+        std::string            hex;
+        for (auto ch : jefe.sign("what do ya want for nothing?")) hex += std::format("{:02x}", static_cast<unsigned char>(ch));
+        EXPECT_EQ("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", hex);
+
+        // Lengths across the padding boundaries and keys either side of the block size
+        std::string message;
+        for (const auto& key : {std::string {"key"}, std::string(64, 'k'), std::string(65, 'k')}) {
+            NativeHmacSha256Signer native {key};
+            HmacSha256Signer       openssl {key};
+
+            for (message.clear(); message.size() <= 200; message.push_back(static_cast<char>('0' + (message.size() % 75)))) {
+                EXPECT_EQ(openssl.sign(message), native.sign(message)) << message.size();
+            }
+        }
+
+        EXPECT_THROW(NativeHmacSha256Signer {std::string_view {}}, std::invalid_argument);
+    }
+
+    TEST(EncryptionUtils, HMACBatch_matches_HMAC)
+    {
+        auto decodedKey = Base64Utils::decode(
+                std::string {"dsZQi3KtZmCv1ljt3VNWNm7sQUF1y5rJfC6kv5JiwvW0EndXdDku/dkKBp8/ufDToSxLzR4y+O/0H/t4bQtVNw=="});
+        std::vector<std::string> storage;
+        for (std::size_t length = 1; length <= 150; length++) storage.push_back(std::string(length, static_cast<char>('a' + (length % 26))));
+        std::vector<std::string_view> messages(storage.begin(), storage.end());
+
+        // A key longer than the block size is hashed first
+        for (const auto& key : {decodedKey, std::string {"key"}, std::string(100, 'k')}) {
+            std::vector<EncryptionUtils::HmacDigest> digests(messages.size());
+            auto                                     signatures = EncryptionUtils::HMACBatch(key, messages, digests);
+
+            ASSERT_EQ(messages.size(), signatures.size());
+            for (std::size_t i = 0; i < messages.size(); i++) {
+                EXPECT_EQ(EncryptionUtils::HMAC(storage[i], key),
+                          std::string(reinterpret_cast<const char*>(signatures[i].data()), signatures[i].size()));
+            }
+        }
+
+        // Unlike HMAC the empty message is signed
+        std::array<std::string_view, 2>          pair {"", "message"};
+        std::array<EncryptionUtils::HmacDigest, 2> digests {};
+        EncryptionUtils::HMACBatch("key", pair, digests);
+        EXPECT_EQ(HmacSha256Signer {std::string_view {"key"}}.sign(""),
+                  std::string(reinterpret_cast<const char*>(digests[0].data()), digests[0].size()));
+        EXPECT_EQ("bp7ym3X//Ft6uuUn1Y/a2y/kLnIZARl2kXNDBl9Y7Uo=",
+                  Base64Utils::encode(std::string(reinterpret_cast<const char*>(digests[1].data()), digests[1].size())));
+    }
+
+    TEST(EncryptionUtils, HMACBatch_per_message_keys)
+    {
+        std::vector<std::string>      keyStorage {"alpha", "alpha", "beta", std::string(80, 'z')};
+        std::vector<std::string_view> keys(keyStorage.begin(), keyStorage.end());
+        std::vector<std::string_view> messages {"get\ndbs\n\n", "put\ncolls\ndbs/x\n", "message", std::string_view {}};
+        std::vector<EncryptionUtils::HmacDigest> digests(messages.size());
+
+        EncryptionUtils::HMACBatch(keys, messages, digests);
+        for (std::size_t i = 0; i < messages.size(); i++) {
+            EXPECT_EQ(HmacSha256Signer {keys[i]}.sign(messages[i]),
+                      std::string(reinterpret_cast<const char*>(digests[i].data()), digests[i].size()));
+        }
+
+        EXPECT_THROW(EncryptionUtils::HMACBatch(std::span(keys).first(3), messages, digests), std::invalid_argument);
+        EXPECT_THROW(EncryptionUtils::HMACBatch(keys, messages, std::span(digests).first(2)), std::invalid_argument);
+        EXPECT_THROW(EncryptionUtils::HMACBatch(std::string_view {}, messages, digests), std::invalid_argument);
+    }
+
+    TEST(Digest, streaming_matches_calcDigest)
+    {
+        Digest md5 {DigestType::MD5};
+
+        EXPECT_EQ(16, md5.size());
+        EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", md5.update("a").update("").update("bc").finalHex());
+        // Ready for the next payload; the empty payload is the Content-MD5 of an empty blob
+        EXPECT_EQ("1B2M2Y8AsgTpgAmY7PhCfg==", md5.finalBase64());
+        md5.update("discarded");
+        md5.reset();
+        EXPECT_EQ("kAFQmDzST7DWlj99KOF/cg==", md5.update("abc").finalBase64());
+
+        // A large payload in uneven blocks
+        std::string payload(1 << 20, 0);
+        for (std::size_t i = 0; i < payload.size(); i++) payload[i] = static_cast<char>(i * 31);
+
+        Digest sha256 {DigestType::SHA256};
+        for (std::size_t offset = 0; offset < payload.size(); offset += 4099) {
+            sha256.update(std::as_bytes(std::span(payload)).subspan(offset, std::min<std::size_t>(4099, payload.size() - offset)));
+        }
+        std::array<std::byte, 32> raw {};
+        std::string               hex;
+        EXPECT_EQ(32, sha256.final(raw));
+        for (auto ch : raw) hex += std::format("{:02x}", static_cast<unsigned char>(ch));
+        EXPECT_EQ(EncryptionUtils::calcDigest(DigestType::SHA256, payload), hex);
+        EXPECT_EQ(hex, sha256.update(payload).finalHex());
+
+        std::array<std::byte, 16> small {};
+        EXPECT_THROW(sha256.final(small), std::invalid_argument);
+    }
+
+    TEST(EncryptionUtils, CosmosToken_into_buffer)
+    {
+        auto decodedKey = Base64Utils::decode(
+                std::string_view {"dsZQi3KtZmCv1ljt3VNWNm7sQUF1y5rJfC6kv5JiwvW0EndXdDku/dkKBp8/ufDToSxLzR4y+O/0H/t4bQtVNw=="});
+        std::array<char, EncryptionUtils::CosmosTokenSize> buffer {};
+
+        auto token = EncryptionUtils::CosmosToken(decodedKey, "GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:12 GMT", buffer);
+        EXPECT_EQ("type%3dmaster%26ver%3d1.0%26sig%3dc09PEVJrgp2uQRkr934kFbTqhByc7TVr3OHyqlu%2bc%2bc%3d", token);
+        EXPECT_EQ(buffer.data(), token.data());
+
+        // Either signer backend; a resource link too long for the stack buffer
+        const NativeHmacSha256Signer native {decodedKey};
+        const HmacSha256Signer       openssl {decodedKey};
+        const std::string            longLink = "dbs/ToDoList/colls/" + std::string(600, 'c');
+        const std::string            date {"Thu, 27 Apr 2017 00:51:12 GMT"};
+        for (std::string_view link : {std::string_view {"dbs/ToDoList"}, std::string_view {longLink}}) {
+            const auto expected = EncryptionUtils::CosmosToken<char>(decodedKey, std::string_view {"POST"}, "docs", link, date);
+
+            EXPECT_EQ(expected, EncryptionUtils::CosmosToken(native, "POST", "docs", link, date, buffer));
+            EXPECT_EQ(expected, EncryptionUtils::CosmosToken(openssl, "POST", "docs", link, date, buffer));
+            EXPECT_EQ(expected,
+                      "type%3dmaster%26ver%3d1.0%26sig%3d" +
+                              UrlUtils::encode(Base64Utils::encode(EncryptionUtils::HMAC(
+                                                       std::format("post\ndocs\n{}\nthu, 27 apr 2017 00:51:12 gmt\n\n", link),
+                                                       decodedKey)),
+                                               true));
+        }
+
+        EXPECT_THROW(EncryptionUtils::CosmosToken("", "GET", "dbs", "dbs/ToDoList", date, buffer), std::invalid_argument);
+        EXPECT_THROW(EncryptionUtils::CosmosToken(native, "", "dbs", "dbs/ToDoList", date, buffer), std::invalid_argument);
+        EXPECT_THROW(EncryptionUtils::CosmosToken(native, "GET", "dbs", "dbs/ToDoList", "", buffer), std::invalid_argument);
+    }
+#endif
+
+    // ---- SasTokenCache ----
+
+    TEST(SasTokenCache, reuse_and_refresh)
+    {
+        using namespace std::chrono_literals;
+
+        SasTokenCache cache {1h, 5min};
+        const auto    start = SasTokenCache::Clock::now();
+        auto          first = cache.get("key", "sb://ns.servicebus.windows.net/queue", "RootManageSharedAccessKey", start);
+
+        // Identical to signing directly with the same expiry
+        const auto expiry = std::chrono::time_point_cast<std::chrono::seconds>(start) + 1h;
+        EXPECT_EQ(EncryptionUtils::SASToken<char>("key",
+                                                  std::string {"sb://ns.servicebus.windows.net/queue"},
+                                                  std::string {"RootManageSharedAccessKey"},
+                                                  std::to_string(expiry.time_since_epoch().count())),
+                  first->value);
+        EXPECT_EQ(expiry, first->expiry);
+
+        // The same token is shared until it is within the skew
+        EXPECT_EQ(first, cache.get("key", "sb://ns.servicebus.windows.net/queue", "RootManageSharedAccessKey", start + 50min));
+        auto refreshed = cache.get("key", "sb://ns.servicebus.windows.net/queue", "RootManageSharedAccessKey", start + 56min);
+        EXPECT_NE(first, refreshed);
+        EXPECT_EQ(expiry + 56min, refreshed->expiry);
+        // The earlier token is still usable by whoever holds it
+        EXPECT_FALSE(first->value.empty());
+
+        // Entities are keyed by url and key name
+        EXPECT_NE(refreshed, cache.get("key", "sb://ns.servicebus.windows.net/queue", "Send", start + 56min));
+        EXPECT_NE(refreshed, cache.get("key", "sb://ns.servicebus.windows.net/topic", "RootManageSharedAccessKey", start + 56min));
+        EXPECT_EQ(3, cache.size());
+
+        cache.clear();
+        EXPECT_EQ(0, cache.size());
+        EXPECT_THROW(cache.get("key", "", "Send"), std::invalid_argument);
+    }
+
+    TEST(SasTokenCache, concurrent_get)
+    {
+        SasTokenCache            cache;
+        std::atomic<int>         failures {0};
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t < 4; t++) {
+            workers.emplace_back([&cache, &failures, t] {
+                for (int i = 0; i < 2000; i++) {
+                    const auto url   = std::format("sb://ns.servicebus.windows.net/queue{}", (i + t) % 100);
+                    auto       token = cache.get("key", url, "Send");
+                    if (!token || !token->value.starts_with("SharedAccessSignature sr=")) failures++;
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        EXPECT_EQ(0, failures.load());
+        EXPECT_EQ(100, cache.size());
+    }
+
+    // ---- CosmosTokenCache ----
+
+    TEST(CosmosTokenCache, memoize_per_second)
+    {
+        auto decodedKey = Base64Utils::decode(
+                std::string {"dsZQi3KtZmCv1ljt3VNWNm7sQUF1y5rJfC6kv5JiwvW0EndXdDku/dkKBp8/ufDToSxLzR4y+O/0H/t4bQtVNw=="});
+        CosmosTokenCache cache {decodedKey};
+
+        const std::string expected {"type%3dmaster%26ver%3d1.0%26sig%3dc09PEVJrgp2uQRkr934kFbTqhByc7TVr3OHyqlu%2bc%2bc%3d"};
+        EXPECT_EQ(expected, cache.get("GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:12 GMT"));
+        // The verb and type are matched as they are signed: in lowercase
+        EXPECT_EQ(expected, cache.get("get", "DBS", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:12 GMT"));
+        EXPECT_EQ(1, cache.statistics().misses);
+        EXPECT_EQ(1, cache.statistics().hits);
+
+        EXPECT_EQ(EncryptionUtils::CosmosToken<char>(
+                          decodedKey, "POST", "docs", "dbs/ToDoList/colls/Items", "Thu, 27 Apr 2017 00:51:12 GMT"),
+                  cache.get("POST", "docs", "dbs/ToDoList/colls/Items", "Thu, 27 Apr 2017 00:51:12 GMT"));
+        EXPECT_EQ(2, cache.size());
+
+        // The next second starts a new generation
+        EXPECT_EQ(EncryptionUtils::CosmosToken<char>(decodedKey, "GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:13 GMT"),
+                  cache.get("GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:13 GMT"));
+        EXPECT_EQ(1, cache.size());
+        EXPECT_EQ(3, cache.statistics().misses);
+
+        // A request that formatted its date before the tick still finds the previous second
+        EXPECT_EQ(expected, cache.get("GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:12 GMT"));
+        EXPECT_EQ(2, cache.statistics().hits);
+        EXPECT_EQ(1, cache.size());
+
+        // Until a newer date drops it
+        cache.get("GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:14 GMT");
+        EXPECT_EQ(expected, cache.get("GET", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:12 GMT"));
+        EXPECT_EQ(5, cache.statistics().misses);
+
+        EXPECT_THROW(cache.get("", "dbs", "dbs/ToDoList", "Thu, 27 Apr 2017 00:51:13 GMT"), std::invalid_argument);
+    }
+
+    TEST(CosmosTokenCache, older_dates_are_not_kept)
+    {
+        CosmosTokenCache cache {"key"};
+        auto             token = [](std::string_view resourceLink, std::string_view date) {
+            return EncryptionUtils::CosmosToken<char>("key", "GET", "docs", resourceLink, date);
+        };
+
+        EXPECT_EQ(token("dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"),
+                  cache.get("GET", "docs", "dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"));
+
+        // An older date interleaved with the live second is signed but neither kept nor allowed to replace it
+        for (int i = 0; i < 3; i++) {
+            EXPECT_EQ(token("dbs/a", "Wed, 26 Apr 2017 23:59:59 GMT"),
+                      cache.get("GET", "docs", "dbs/a", "Wed, 26 Apr 2017 23:59:59 GMT"));
+            EXPECT_EQ(token("dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"),
+                      cache.get("GET", "docs", "dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"));
+        }
+        EXPECT_EQ(3, cache.statistics().hits);
+        EXPECT_EQ(4, cache.statistics().misses);
+        EXPECT_EQ(1, cache.size());
+
+        // Neither is a malformed date
+        EXPECT_EQ(token("dbs/a", "yesterday"), cache.get("GET", "docs", "dbs/a", "yesterday"));
+        EXPECT_EQ(token("dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"),
+                  cache.get("GET", "docs", "dbs/a", "Thu, 27 Apr 2017 00:51:13 GMT"));
+        EXPECT_EQ(4, cache.statistics().hits);
+        EXPECT_EQ(1, cache.size());
+    }
+
+    TEST(CosmosTokenCache, bounded)
+    {
+        CosmosTokenCache cache {"key", 8};
+
+        for (int i = 0; i < 20; i++) {
+            auto resourceLink = std::format("dbs/db/colls/c/docs/{}", i);
+            EXPECT_EQ(EncryptionUtils::CosmosToken<char>("key", "GET", "docs", resourceLink, "Thu, 27 Apr 2017 00:51:12 GMT"),
+                      cache.get("GET", "docs", resourceLink, "Thu, 27 Apr 2017 00:51:12 GMT"));
+        }
+
+        EXPECT_EQ(8, cache.size());
+        EXPECT_EQ(20, cache.statistics().misses);
+    }
 } // namespace siddiqsoft
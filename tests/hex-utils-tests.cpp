@@ -0,0 +1,128 @@
+﻿/*
+    AzureCppUtils : Azure Utilities for Modern C++
+
+    BSD 3-Clause License
+
+    Copyright (c) 2021, Siddiq Software
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+    2. Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+    3. Neither the name of the copyright holder nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+    FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+    DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+    SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+    CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/siddiqsoft/hex-utils.hpp"
+
+namespace siddiqsoft
+{
+    TEST(HexUtils, encode)
+    {
+        EXPECT_EQ("", HexUtils::encode(std::string_view {}));
+        EXPECT_EQ("00ff7f80", HexUtils::encode(std::string_view {"\x00\xff\x7f\x80", 4}));
+        EXPECT_EQ("00FF7F80", HexUtils::encode(std::string_view {"\x00\xff\x7f\x80", 4}, true));
+        EXPECT_EQ("616263", HexUtils::encode("abc"));
+
+        std::array<char, 6> dest {};
+        EXPECT_EQ(6, HexUtils::encodeInto(std::as_bytes(std::span(std::string_view {"abc"})), dest));
+        EXPECT_EQ("616263", std::string_view(dest.data(), dest.size()));
+        EXPECT_THROW(HexUtils::encodeInto(std::as_bytes(std::span(std::string_view {"abcd"})), dest), std::invalid_argument);
+    }
+
+    TEST(HexUtils, decode)
+    {
+        EXPECT_EQ("abc", HexUtils::decode("616263"));
+        EXPECT_EQ(std::string("\x00\xff\xab", 3), HexUtils::decode("00fFAb"));
+        EXPECT_EQ("", HexUtils::decode(""));
+
+        // Odd length and characters outside the alphabet
+        EXPECT_EQ("", HexUtils::decode("616"));
+        EXPECT_EQ("", HexUtils::decode("6g"));
+
+        std::array<std::byte, 4> dest {};
+        auto                     result = HexUtils::decodeInto("0102x3", dest);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(2, result.written);
+        EXPECT_EQ(4, result.errorOffset);
+        EXPECT_EQ(1, HexUtils::decodeInto("010", dest).written);
+        EXPECT_EQ(2, HexUtils::decodeInto("010", dest).errorOffset);
+        EXPECT_THROW(HexUtils::decodeInto("0102030405", dest), std::invalid_argument);
+    }
+
+    TEST(HexUtils, kernels_match_scalar)
+    {
+        std::string source(300, 0);
+        for (std::size_t i = 0; i < source.size(); i++) source[i] = static_cast<char>((i * 37) + 11);
+
+        for (auto kernel : {HexUtils::Kernel::Scalar, HexUtils::Kernel::SSE41, HexUtils::Kernel::AVX2}) {
+            if (!HexUtils::isSupported(kernel)) continue;
+
+            // Every length up to a few vector blocks so each kernel ends with a scalar tail
+            for (std::size_t length = 0; length <= 140; length++) {
+                for (bool upperCase : {false, true}) {
+                    std::string encoded(length * 2, 0);
+                    std::string expected;
+
+                    HexUtils::encode(
+                            reinterpret_cast<const unsigned char*>(source.data()), length, encoded.data(), upperCase, kernel);
+                    for (std::size_t i = 0; i < length; i++) {
+                        const auto ch = static_cast<unsigned char>(source[i]);
+                        expected += (upperCase ? HexUtils::UpperDigits : HexUtils::LowerDigits)[ch >> 4];
+                        expected += (upperCase ? HexUtils::UpperDigits : HexUtils::LowerDigits)[ch & 0x0f];
+                    }
+                    ASSERT_EQ(expected, encoded) << "kernel " << static_cast<int>(kernel) << " length " << length;
+
+                    std::string decoded(length, 0);
+                    auto        result = HexUtils::decode(
+                            encoded.data(), encoded.length(), reinterpret_cast<unsigned char*>(decoded.data()), kernel);
+                    ASSERT_TRUE(result);
+                    ASSERT_EQ(source.substr(0, length), decoded);
+                }
+            }
+
+            // An invalid character anywhere is reported at its own offset
+            const auto encoded = HexUtils::encode(std::string_view {source}.substr(0, 100));
+            for (std::size_t offset = 0; offset < encoded.length(); offset += 7) {
+                for (char invalid : {'g', 'G', '/', ':', '@', '`', '\x80', ' '}) {
+                    auto corrupt    = encoded;
+                    corrupt[offset] = invalid;
+
+                    std::vector<unsigned char> decoded(corrupt.length() / 2);
+                    auto result = HexUtils::decode(corrupt.data(), corrupt.length(), decoded.data(), kernel);
+                    EXPECT_FALSE(result);
+                    EXPECT_EQ(offset, result.errorOffset) << "kernel " << static_cast<int>(kernel);
+                }
+            }
+        }
+    }
+} // namespace siddiqsoft
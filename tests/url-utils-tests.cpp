@@ -1,4 +1,4 @@
-/*
+﻿/*
     AzureCppUtils : Azure Utilities for Modern C++
 
     BSD 3-Clause License
@@ -38,8 +38,14 @@
 #include <iostream>
 #include <format>
 #include <string>
+#include <random>
+#include <cctype>
+#include <array>
+#include <span>
+#include <vector>
 #include "siddiqsoft/conversion-utils.hpp"
 #include "../include/siddiqsoft/url-utils.hpp"
+#include "../include/siddiqsoft/url-builder.hpp"
 
 namespace siddiqsoft
 {
@@ -270,4 +276,273 @@ namespace siddiqsoft
         auto         result = UrlUtils::encode<wchar_t>(src, true);
         EXPECT_EQ(L"https%3a%2f%2fexample.com%2fpath%3fq%3dtest", result);
     }
+
+    /// @brief The original per-character implementation; every byte is formatted as unsigned
+    static std::string referenceEncode(const std::string& source, bool lowerCase)
+    {
+        std::string result;
+
+        for (unsigned char ch : source) {
+            if (std::isalnum(ch) || (ch == '.') || (ch == '-') || (ch == '~') || (ch == '_'))
+                result.push_back(static_cast<char>(ch));
+            else
+                result += lowerCase ? std::format("%{:02x}", ch) : std::format("%{:02X}", ch);
+        }
+
+        return result;
+    }
+
+    TEST(UrlUtils, encode_all_byte_values)
+    {
+        std::string source;
+        for (int ch = 0; ch < 256; ch++) source.push_back(static_cast<char>(ch));
+
+        EXPECT_EQ(referenceEncode(source, false), UrlUtils::encode(source));
+        EXPECT_EQ(referenceEncode(source, true), UrlUtils::encode(source, true));
+    }
+
+    TEST(UrlUtils, encode_matches_reference)
+    {
+        // Runs of unreserved characters of every length around the 16 and 32 byte vector blocks
+        std::mt19937                       rng {2021};
+        std::uniform_int_distribution<int> runDist(0, 70);
+        std::uniform_int_distribution<int> byteDist(0, 255);
+        const std::string                  unreserved {"abcXYZ019-._~"};
+
+        for (int round = 0; round < 500; round++) {
+            std::string source;
+            while (source.length() < static_cast<std::size_t>(round)) {
+                for (auto run = runDist(rng); run > 0; run--) source.push_back(unreserved[run % unreserved.length()]);
+                source.push_back(static_cast<char>(byteDist(rng)));
+            }
+
+            ASSERT_EQ(referenceEncode(source, false), UrlUtils::encode(source)) << source;
+            ASSERT_EQ(referenceEncode(source, true), UrlUtils::encode(source, true)) << source;
+        }
+    }
+
+    TEST(UrlUtils, decode_basic)
+    {
+        EXPECT_EQ("https://example.com/path?q=test", UrlUtils::decode(std::string {"https%3A%2F%2Fexample.com%2Fpath%3Fq%3Dtest"}));
+        EXPECT_EQ("https://example.com", UrlUtils::decode(std::string {"https%3a%2f%2fexample.com"}));
+        EXPECT_EQ("no escapes", UrlUtils::decode(std::string {"no escapes"}));
+        EXPECT_EQ("", UrlUtils::decode(std::string {}));
+        EXPECT_EQ("%", UrlUtils::decode(std::string {"%25"}));
+    }
+
+    TEST(UrlUtils, decode_plus)
+    {
+        // Only form-encoded input treats '+' as a space
+        EXPECT_EQ("a+b", UrlUtils::decode(std::string {"a+b"}));
+        EXPECT_EQ("a b", UrlUtils::decode(std::string {"a+b"}, true));
+        EXPECT_EQ("a+b c", UrlUtils::decode(std::string {"a%2Bb+c"}, true));
+    }
+
+    TEST(UrlUtils, decode_malformed)
+    {
+        std::size_t errorOffset {};
+
+        EXPECT_EQ("", UrlUtils::decode(std::string {"abc%4"}, errorOffset));
+        EXPECT_EQ(3, errorOffset);
+        EXPECT_EQ("", UrlUtils::decode(std::string {"abc%"}, errorOffset));
+        EXPECT_EQ(3, errorOffset);
+        EXPECT_EQ("", UrlUtils::decode(std::string {"%41%G1"}, errorOffset));
+        EXPECT_EQ(3, errorOffset);
+        EXPECT_EQ("A", UrlUtils::decode(std::string {"%41"}, errorOffset));
+        EXPECT_EQ(UrlUtils::npos, errorOffset);
+    }
+
+    TEST(UrlUtils, decode_wchar)
+    {
+        std::size_t errorOffset {};
+
+        EXPECT_EQ(L"https://example.com/\u00e9", UrlUtils::decode<wchar_t>(std::wstring {L"https%3A%2F%2Fexample.com%2F%C3%A9"}));
+        EXPECT_EQ(L"\u00e9 \u00e9", UrlUtils::decode<wchar_t>(std::wstring {L"\u00e9+%C3%A9"}, true));
+        // The offset is reported in wchar_t
+        EXPECT_EQ(L"", UrlUtils::decode<wchar_t>(std::wstring {L"\u00e9\u00e9%Z0"}, errorOffset));
+        EXPECT_EQ(2, errorOffset);
+    }
+
+    TEST(UrlUtils, decodeInto_span)
+    {
+        std::array<char, 16> dest {};
+
+        auto result = UrlUtils::decodeInto("a%20b", std::span<char>(dest));
+        EXPECT_TRUE(result);
+        EXPECT_EQ("a b", std::string_view(dest.data(), result.written));
+
+        result = UrlUtils::decodeInto("a%2", std::span<char>(dest));
+        EXPECT_FALSE(result);
+        EXPECT_EQ(1, result.errorOffset);
+
+        EXPECT_THROW(UrlUtils::decodeInto("a%20b", std::span<char>(dest.data(), 4)), std::invalid_argument);
+    }
+
+    TEST(UrlUtils, decodeInto_buffer)
+    {
+        std::string dest {"prefix:"};
+
+        auto result = UrlUtils::decodeInto("a%20b", dest);
+        EXPECT_TRUE(result);
+        EXPECT_EQ("prefix:a b", dest);
+
+        // On failure the buffer is left as it was
+        result = UrlUtils::decodeInto("c%zz", dest);
+        EXPECT_FALSE(result);
+        EXPECT_EQ(1, result.errorOffset);
+        EXPECT_EQ("prefix:a b", dest);
+
+        std::vector<std::byte> bytes;
+        EXPECT_TRUE(UrlUtils::decodeInto("%00%FF", bytes));
+        ASSERT_EQ(2, bytes.size());
+        EXPECT_EQ(std::byte {0xff}, bytes[1]);
+    }
+
+    TEST(UrlUtils, decode_roundtrip)
+    {
+        // Runs of plain characters of every length around the 16 and 32 byte vector blocks
+        std::mt19937                       rng {2021};
+        std::uniform_int_distribution<int> runDist(0, 70);
+        std::uniform_int_distribution<int> byteDist(0, 255);
+        const std::string                  unreserved {"abcXYZ019-._~"};
+
+        for (int round = 0; round < 500; round++) {
+            std::string source;
+            while (source.length() < static_cast<std::size_t>(round)) {
+                for (auto run = runDist(rng); run > 0; run--) source.push_back(unreserved[run % unreserved.length()]);
+                source.push_back(static_cast<char>(byteDist(rng)));
+            }
+
+            ASSERT_EQ(source, UrlUtils::decode(UrlUtils::encode(source))) << source;
+            ASSERT_EQ(source, UrlUtils::decode(UrlUtils::encode(source, true), true)) << source;
+        }
+    }
+
+    TEST(UrlUtils, encode_policies)
+    {
+        const std::string blob {"dir one/file+name (1).txt"};
+
+        EXPECT_EQ("dir%20one%2Ffile%2Bname%20%281%29.txt", UrlUtils::encode<UrlUtils::Component<>>(blob));
+        EXPECT_EQ("dir%20one%2Ffile+name%20(1).txt", UrlUtils::encode<UrlUtils::PathSegment<>>(blob));
+        EXPECT_EQ("dir%20one/file+name%20(1).txt", UrlUtils::encode<UrlUtils::Path<>>(blob));
+        EXPECT_EQ("dir%20one/file%2Bname%20(1).txt", UrlUtils::encode<UrlUtils::QueryValue<>>(blob));
+        EXPECT_EQ("dir+one%2Ffile%2Bname+%281%29.txt", UrlUtils::encode<UrlUtils::Form<>>(blob));
+        EXPECT_EQ("a%3db%26c", UrlUtils::encode<UrlUtils::QueryValue<true>>(std::string {"a=b&c"}));
+        EXPECT_EQ(L"dir%20one/%C3%A9", (UrlUtils::encode<UrlUtils::Path<>, wchar_t>(std::wstring {L"dir one/\u00e9"})));
+
+        // The runtime flag matches the Component policy
+        EXPECT_EQ(UrlUtils::encode<UrlUtils::Component<true>>(blob), UrlUtils::encode(blob, true));
+    }
+
+    TEST(UrlUtils, encode_policies_roundtrip)
+    {
+        std::string source;
+        for (int ch = 0; ch < 256; ch++) source.push_back(static_cast<char>(ch));
+
+        EXPECT_EQ(source, UrlUtils::decode(UrlUtils::encode<UrlUtils::PathSegment<>>(source)));
+        EXPECT_EQ(source, UrlUtils::decode(UrlUtils::encode<UrlUtils::Path<true>>(source)));
+        EXPECT_EQ(source, UrlUtils::decode(UrlUtils::encode<UrlUtils::QueryValue<>>(source)));
+        EXPECT_EQ(source, UrlUtils::decode(UrlUtils::encode<UrlUtils::Form<>>(source), true));
+    }
+
+    TEST(UrlUtils, encode_wchar_fused)
+    {
+        // Code points of each UTF-8 length; the escapes match the narrow encode of the UTF-8 source
+        std::wstring source {L"a \u00e9\u20ac\U0001F600/~"};
+        EXPECT_EQ(L"a%20%C3%A9%E2%82%AC%F0%9F%98%80%2F~", UrlUtils::encode<wchar_t>(source));
+        EXPECT_EQ(L"a+%c3%a9%e2%82%ac%f0%9f%98%80%2f%7e", (UrlUtils::encode<UrlUtils::Form<true>, wchar_t>(source)));
+
+        // Nothing to escape returns the source
+        EXPECT_EQ(L"plain-text_1.0", UrlUtils::encode<wchar_t>(std::wstring {L"plain-text_1.0"}));
+        EXPECT_EQ(L"", UrlUtils::encode<wchar_t>(std::wstring {}));
+
+        // Lone surrogates (and values beyond Unicode where wchar_t is 32-bit) are encoded as U+FFFD
+        std::wstring invalid {L"x"};
+        invalid.push_back(static_cast<wchar_t>(0xd800));
+        invalid.push_back(L'y');
+        EXPECT_EQ(L"x%EF%BF%BDy", UrlUtils::encode<wchar_t>(invalid));
+    }
+
+    TEST(UrlUtils, encode_wchar_matches_narrow)
+    {
+        std::mt19937                       rng {2021};
+        std::uniform_int_distribution<int> cpDist(0, 0x2ff);
+
+        for (int round = 0; round < 200; round++) {
+            std::wstring source;
+            for (int i = 0; i < round; i++) source.push_back(static_cast<wchar_t>(cpDist(rng)));
+
+            auto narrow = ConversionUtils::convert_to<wchar_t, char>(source);
+            auto expected = ConversionUtils::convert_to<char, wchar_t>(UrlUtils::encode(narrow));
+            ASSERT_EQ(expected, UrlUtils::encode<wchar_t>(source));
+            ASSERT_EQ(source, UrlUtils::decode<wchar_t>(UrlUtils::encode<wchar_t>(source)));
+        }
+    }
+
+
+    TEST(UrlUtils, string_view_inputs)
+    {
+        std::string_view request {"GET /a b/c?x=1"};
+
+        EXPECT_EQ("%2Fa%20b%2Fc", UrlUtils::encode(request.substr(4, 6)));
+        EXPECT_EQ("/a%20b/c", UrlUtils::encode<UrlUtils::Path<>>(request.substr(4, 6)));
+        EXPECT_EQ("a b", UrlUtils::decode("a%20b"));
+        EXPECT_EQ(L"a b", UrlUtils::decode<wchar_t>(L"a+b", true));
+        EXPECT_EQ(L"a%20b", UrlUtils::encode<wchar_t>(L"a b"));
+
+        const std::byte bytes[] {std::byte {0x00}, std::byte {'a'}, std::byte {0xff}};
+        EXPECT_EQ("%00a%FF", UrlUtils::encode(std::span(bytes)));
+        EXPECT_EQ("%00a%ff", UrlUtils::encode<UrlUtils::QueryValue<true>>(std::span(bytes)));
+    }
+    TEST(UrlBuilder, build)
+    {
+        UrlBuilder url {"https", "myaccount.blob.core.windows.net"};
+
+        url.segment("my container").path("folder/file (1).txt").query("comp", "block").query("blockid", "AAA=");
+        EXPECT_EQ("https://myaccount.blob.core.windows.net/my%20container/folder/file%20(1).txt?comp=block&blockid=AAA%3D",
+                  url.str());
+        EXPECT_EQ(url.str().length(), url.size());
+
+        // A single segment escapes the "/"; a path keeps its leading "/"
+        EXPECT_EQ("/a%2Fb/c/d", UrlBuilder {}.segment("a/b").path("/c/d").str());
+        EXPECT_EQ("host", (UrlBuilder {"", "host"}.str()));
+    }
+
+    TEST(UrlBuilder, empty)
+    {
+        // The default scheme and host are null views; nothing is copied from them
+        UrlBuilder url {};
+
+        EXPECT_EQ(0, url.size());
+        EXPECT_EQ("", url.str());
+
+        std::string dest {"GET "};
+        EXPECT_EQ(0, url.writeTo(dest));
+        EXPECT_EQ("GET ", dest);
+        EXPECT_EQ(0, url.writeTo(std::span<char> {}));
+    }
+
+    TEST(UrlBuilder, canonicalQuery)
+    {
+        UrlBuilder url {"https", "example.com"};
+
+        url.query("b", "2").query("a", "2").canonicalQuery().query("a", "1").query("c", "a&b");
+        EXPECT_EQ("https://example.com?a=1&a=2&b=2&c=a%26b", url.str());
+    }
+
+    TEST(UrlBuilder, writeTo)
+    {
+        UrlBuilder url {"https", "example.com"};
+        url.path("x y").query("q", "1 2");
+
+        std::string dest {"GET "};
+        EXPECT_EQ(33, url.writeTo(dest));
+        EXPECT_EQ("GET https://example.com/x%20y?q=1%202", dest);
+
+        std::array<char, 64> buffer {};
+        auto                 written = url.writeTo(std::span<char>(buffer));
+        EXPECT_EQ("https://example.com/x%20y?q=1%202", std::string_view(buffer.data(), written));
+
+        EXPECT_THROW(url.writeTo(std::span<char>(buffer.data(), 8)), std::invalid_argument);
+    }
 } // namespace siddiqsoft